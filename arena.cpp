@@ -0,0 +1,69 @@
+#include "arena.hpp"
+#include <new>
+#include <stdint.h>
+
+void* pb::Arena::allocate(size_t bytes, size_t alignment) {
+    uintptr_t aligned = (reinterpret_cast < uintptr_t >(cur) + alignment - 1) & ~uintptr_t(alignment - 1);
+    if(!cur || (aligned + bytes > reinterpret_cast < uintptr_t >(end))) {
+        // Start a new block. Allocations bigger than a block get one of their own
+        size_t size = sizeof(Block) + alignment + ((bytes > blockSize) ? bytes : blockSize);
+        Block* block = static_cast < Block* >(::operator new(size));
+        block->next = head;
+        block->size = size;
+        head = block;
+        cur = reinterpret_cast < char* >(block + 1);
+        end = reinterpret_cast < char* >(block) + size;
+        ++blocks;
+        reserved += size;
+        aligned = (reinterpret_cast < uintptr_t >(cur) + alignment - 1) & ~uintptr_t(alignment - 1);
+    }
+    cur = reinterpret_cast < char* >(aligned + bytes);
+    ++allocations;
+    allocated += bytes;
+    return reinterpret_cast < void* >(aligned);
+}
+
+void pb::Arena::release() {
+    while(head) {
+        Block* next = head->next;
+        ::operator delete(head);
+        head = next;
+    }
+    cur = 0;
+    end = 0;
+    allocations = 0;
+    allocated = 0;
+    blocks = 0;
+    reserved = 0;
+}
+
+size_t pb::Arena::allocationCount() const {
+    return allocations;
+}
+
+size_t pb::Arena::bytesAllocated() const {
+    return allocated;
+}
+
+size_t pb::Arena::blockCount() const {
+    return blocks;
+}
+
+size_t pb::Arena::bytesReserved() const {
+    return reserved;
+}
+
+pb::Arena::Arena(size_t p_blockSize) :
+    head(0),
+    cur(0),
+    end(0),
+    blockSize(p_blockSize),
+    allocations(0),
+    allocated(0),
+    blocks(0),
+    reserved(0)
+{ }
+
+pb::Arena::~Arena() {
+    release();
+}
@@ -0,0 +1,73 @@
+#ifndef ARENA_INCLUDED
+#define ARENA_INCLUDED
+
+/*
+    Monotonic arena allocation for pointybox data.
+    An Arena hands out memory from a few large blocks and never frees individual allocations; everything is released at once by release() or when the arena is destroyed.
+    ArenaAllocator adapts an Arena for standard containers. ArenaVector uses it through std::scoped_allocator_adaptor, so nested vectors (like the ones in the Arena* container typedefs in pointybox.hpp) all allocate from the same arena.
+    Containers using an arena must be destroyed before it is released; destroying them is cheap as their deallocations do nothing.
+    Arenas are not thread safe.
+*/
+
+#include <scoped_allocator>
+#include <stddef.h>
+#include <vector>
+
+namespace pb {
+    class Arena {
+        struct Block {
+            Block* next;
+            size_t size;
+        };
+
+        Block* head;
+        char* cur;
+        char* end;
+        size_t blockSize,
+               allocations,
+               allocated,
+               blocks,
+               reserved;
+
+    public:
+        void* allocate(size_t bytes, size_t alignment);
+        void release();
+
+        size_t allocationCount() const;     // Allocations handed out since the last release
+        size_t bytesAllocated() const;      // Bytes handed out since the last release
+        size_t blockCount() const;          // Blocks currently held
+        size_t bytesReserved() const;       // Bytes currently held in blocks
+
+        Arena(size_t p_blockSize = 65536);
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+        ~Arena();
+    };
+
+    template < typename T >
+    class ArenaAllocator {
+        template < typename U > friend class ArenaAllocator;
+        Arena* arena;
+
+    public:
+        typedef T value_type;
+
+        T* allocate(size_t n) { return static_cast < T* >(arena->allocate(n * sizeof(T), alignof(T))); }
+        void deallocate(T*, size_t) { }
+        Arena* getArena() const { return arena; }
+
+        ArenaAllocator(Arena* p_arena) : arena(p_arena) { }
+        template < typename U >
+        ArenaAllocator(const ArenaAllocator < U >& other) : arena(other.arena) { }
+    };
+
+    template < typename T, typename U >
+    bool operator==(const ArenaAllocator < T >& a, const ArenaAllocator < U >& b) { return a.getArena() == b.getArena(); }
+    template < typename T, typename U >
+    bool operator!=(const ArenaAllocator < T >& a, const ArenaAllocator < U >& b) { return a.getArena() != b.getArena(); }
+
+    template < typename T >
+    using ArenaVector = std::vector < T, std::scoped_allocator_adaptor < ArenaAllocator < T > > >;
+}
+
+#endif
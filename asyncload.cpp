@@ -0,0 +1,139 @@
+#include "asyncload.hpp"
+#include <algorithm>
+#include <exception>
+
+void pb::LoadHandle::run() {
+    if(progress.cancel.load(std::memory_order_relaxed)) {
+        finish(Cancelled);
+        return;
+    }
+    status.store(Loading, std::memory_order_release);
+    PointyboxLoader ploader(file);
+    bool parsed;
+    try {
+        parsed = ploader.parse(&resolution, &aabbVec, &pointVec, &edgeVec, &progress);
+    }
+    catch (const std::exception&) { // Invalid numbers make std::stoi throw; nothing may escape a pool thread
+        parsed = false;
+    }
+    if(parsed) {
+        finish(Done);
+        return;
+    }
+    // Don't leave partial results behind
+    aabbVec = AABBVector();
+    pointVec = PointVector();
+    edgeVec = EdgeVector();
+    finish(progress.cancel.load(std::memory_order_relaxed) ? Cancelled : Failed);
+}
+
+void pb::LoadHandle::finish(Status result) {
+    std::lock_guard < std::mutex > lock(mutex);
+    status.store(result, std::memory_order_release);
+    finished.notify_all();
+}
+
+const std::string& pb::LoadHandle::getFile() const {
+    return file;
+}
+
+pb::LoadHandle::Status pb::LoadHandle::getStatus() const {
+    return Status(status.load(std::memory_order_acquire));
+}
+
+bool pb::LoadHandle::ready() const {
+    return getStatus() >= Done;
+}
+
+pb::LoadHandle::Status pb::LoadHandle::wait() const {
+    std::unique_lock < std::mutex > lock(mutex);
+    finished.wait(lock, [this]() { return ready(); });
+    return getStatus();
+}
+
+void pb::LoadHandle::cancel() {
+    progress.cancel.store(true, std::memory_order_relaxed);
+}
+
+size_t pb::LoadHandle::bytesDone() const {
+    return progress.bytesDone.load(std::memory_order_relaxed);
+}
+
+size_t pb::LoadHandle::bytesTotal() const {
+    return progress.bytesTotal.load(std::memory_order_relaxed);
+}
+
+size_t pb::LoadHandle::idsDone() const {
+    return progress.idsDone.load(std::memory_order_relaxed);
+}
+
+pb::Vector2u pb::LoadHandle::getResolution() const {
+    return resolution;
+}
+
+pb::AABBVector& pb::LoadHandle::getAABBs() {
+    return aabbVec;
+}
+
+pb::PointVector& pb::LoadHandle::getPoints() {
+    return pointVec;
+}
+
+pb::EdgeVector& pb::LoadHandle::getEdges() {
+    return edgeVec;
+}
+
+pb::LoadHandle::LoadHandle(std::string path) :
+    file(path),
+    status(Queued)
+{ }
+
+void pb::AsyncLoader::work() {
+    std::unique_lock < std::mutex > lock(mutex);
+    while(true) {
+        wake.wait(lock, [this]() { return stopping || !queue.empty(); });
+        if(queue.empty()) // Stopping
+            return;
+        std::shared_ptr < LoadHandle > handle(queue.front());
+        queue.pop_front();
+        running.push_back(handle);
+        lock.unlock();
+        handle->run();
+        lock.lock();
+        running.erase(std::find(running.begin(), running.end(), handle));
+    }
+}
+
+std::shared_ptr < pb::LoadHandle > pb::AsyncLoader::parseAsync(const std::string& path) {
+    std::shared_ptr < LoadHandle > handle(new LoadHandle(path));
+    {
+        std::lock_guard < std::mutex > lock(mutex);
+        queue.push_back(handle);
+    }
+    wake.notify_one();
+    return handle;
+}
+
+pb::AsyncLoader::AsyncLoader(unsigned int threads) :
+    stopping(false)
+{
+    if(threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int i = 0; i < threads; ++i)
+        workers.push_back(std::thread(&AsyncLoader::work, this));
+}
+
+pb::AsyncLoader::~AsyncLoader() {
+    {
+        std::lock_guard < std::mutex > lock(mutex);
+        stopping = true;
+        // Queued handles are finished by the workers as Cancelled, so anyone waiting on them wakes up
+        for (size_t i = 0; i < queue.size(); ++i)
+            queue[i]->cancel();
+        for (size_t i = 0; i < running.size(); ++i)
+            running[i]->cancel();
+    }
+    wake.notify_all();
+    for (size_t i = 0; i < workers.size(); ++i)
+        workers[i].join();
+}
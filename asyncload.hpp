@@ -0,0 +1,86 @@
+#ifndef ASYNCLOAD_INCLUDED
+#define ASYNCLOAD_INCLUDED
+
+/*
+    Background loading of pointybox files.
+    An AsyncLoader owns a fixed pool of worker threads shared by every file queued on it, so several files can parse at once without a thread each.
+    parseAsync() returns a LoadHandle straight away. Poll it for progress (e.g. from a loading screen), cancel() it, or wait() for it.
+    Once a handle is Done it holds the usual parsed containers, which can be moved out of it.
+    Destroying the loader cancels everything still queued or running and waits for the workers.
+*/
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "pointybox.hpp"
+
+namespace pb {
+    class LoadHandle {
+    public:
+        enum Status {
+            Queued,
+            Loading,
+            Done,
+            Failed,     // Missing or invalid file
+            Cancelled
+        };
+
+    private:
+        std::string file;
+        LoadProgress progress;
+        std::atomic < int > status;
+        mutable std::mutex mutex;
+        mutable std::condition_variable finished;
+        Vector2u resolution;
+        AABBVector aabbVec;
+        PointVector pointVec;
+        EdgeVector edgeVec;
+
+        void run();
+        void finish(Status result);
+        friend class AsyncLoader;
+
+    public:
+        const std::string& getFile() const;
+        Status getStatus() const;
+        bool ready() const;     // Done, Failed or Cancelled
+        Status wait() const;
+        void cancel();          // Takes effect before the next tile ID is read. Has no effect once ready
+
+        size_t bytesDone() const;
+        size_t bytesTotal() const;     // File size. 0 until the file has been opened
+        size_t idsDone() const;        // Summed over the file's 3 sections
+
+        // Only valid once the handle is Done
+        Vector2u getResolution() const;
+        AABBVector& getAABBs();
+        PointVector& getPoints();
+        EdgeVector& getEdges();
+
+        LoadHandle(std::string path);
+        LoadHandle(const LoadHandle&) = delete;
+        LoadHandle& operator=(const LoadHandle&) = delete;
+    };
+
+    class AsyncLoader {
+        std::vector < std::thread > workers;
+        std::deque < std::shared_ptr < LoadHandle > > queue;
+        std::vector < std::shared_ptr < LoadHandle > > running;
+        std::mutex mutex;
+        std::condition_variable wake;
+        bool stopping;
+
+        void work();
+
+    public:
+        std::shared_ptr < LoadHandle > parseAsync(const std::string& path);
+
+        AsyncLoader(unsigned int threads = 0); // 0 uses one thread per core
+        AsyncLoader(const AsyncLoader&) = delete;
+        AsyncLoader& operator=(const AsyncLoader&) = delete;
+        ~AsyncLoader();
+    };
+}
+
+#endif
@@ -0,0 +1,206 @@
+#include "autobox.hpp"
+#include <algorithm>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Writes 1 for each solid pixel of an RGBA8 row and 0 for the rest
+static void maskRow(const unsigned char* row, unsigned int width, unsigned char alphaThreshold, unsigned char* out) {
+    unsigned int x = 0;
+#ifdef __SSE2__
+    const __m128i threshold = _mm_set1_epi8(char(alphaThreshold)),
+                  zero = _mm_setzero_si128(),
+                  one = _mm_set1_epi8(1);
+    for (; x + 16 <= width; x += 16) {
+        // Shift alpha down to the low byte of each pixel, then pack 16 pixels worth of alpha into one register
+        __m128i a = _mm_srli_epi32(_mm_loadu_si128(reinterpret_cast < const __m128i* >(row + x * 4)), 24),
+                b = _mm_srli_epi32(_mm_loadu_si128(reinterpret_cast < const __m128i* >(row + x * 4 + 16)), 24),
+                c = _mm_srli_epi32(_mm_loadu_si128(reinterpret_cast < const __m128i* >(row + x * 4 + 32)), 24),
+                d = _mm_srli_epi32(_mm_loadu_si128(reinterpret_cast < const __m128i* >(row + x * 4 + 48)), 24);
+        __m128i alpha = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+        // alpha >= threshold when the saturated threshold - alpha is 0
+        __m128i solid = _mm_and_si128(_mm_cmpeq_epi8(_mm_subs_epu8(threshold, alpha), zero), one);
+        _mm_storeu_si128(reinterpret_cast < __m128i* >(out + x), solid);
+    }
+#endif
+    for (; x < width; ++x)
+        out[x] = (row[x * 4 + 3] >= alphaThreshold);
+}
+
+void pb::AutoboxGenerator::maskImage(std::vector < unsigned char >* imageMask) const {
+    // Whole image rows, so the SIMD path runs even when tiles are narrower than a register
+    unsigned int rows = (size.y / resolution.y) * resolution.y;
+    imageMask->resize(size_t(size.x) * rows);
+    for (unsigned int y = 0; y < rows; ++y)
+        maskRow(pixels + size_t(y) * size.x * 4, size.x, alphaThreshold, imageMask->data() + size_t(y) * size.x);
+}
+
+void pb::AutoboxGenerator::buildMask(size_t tile, const unsigned char* imageMask, unsigned char* mask) const {
+    size_t tilesX = size.x / resolution.x,
+           originX = (tile % tilesX) * resolution.x,
+           originY = (tile / tilesX) * resolution.y;
+    for (unsigned int y = 0; y < resolution.y; ++y)
+        std::copy(imageMask + (originY + y) * size.x + originX, imageMask + (originY + y) * size.x + originX + resolution.x, mask + y * resolution.x);
+}
+
+void pb::AutoboxGenerator::forEachTile(const std::function < void(size_t tile, TileScratch& scratch) >& func) const {
+    size_t count = tileCount();
+    if(count == 0)
+        return;
+    std::unique_ptr < WorkerPool > ownPool;
+    if(threads != 0)
+        ownPool.reset(new WorkerPool(threads));
+    WorkerPool& pool = ownPool ? *ownPool : WorkerPool::shared();
+
+    std::vector < unsigned char > imageMask;
+    maskImage(&imageMask);
+    std::vector < TileScratch > scratch(pool.size());
+    pool.run(count, [&](size_t tile, unsigned int worker) {
+        std::vector < unsigned char >& mask = scratch[worker].mask;
+        mask.resize(resolution.x * resolution.y);
+        buildMask(tile, imageMask.data(), mask.data());
+        func(tile, scratch[worker]);
+    });
+}
+
+size_t pb::AutoboxGenerator::tileCount() const {
+    return size_t(size.x / resolution.x) * (size.y / resolution.y);
+}
+
+size_t pb::AutoboxGenerator::idCount() const {
+    return (tileCount() + 46) / 47;
+}
+
+void pb::AutoboxGenerator::generateAABBs(AABBVectorRaw* aabbVec) const {
+    while(aabbVec->size() < idCount())
+        aabbVec->push_back(std::vector < std::vector < pb::IntRect > >(47, std::vector < pb::IntRect >()));
+
+    unsigned int w = resolution.x,
+                 h = resolution.y;
+    forEachTile([&](size_t tile, TileScratch& scratch) {
+        unsigned char* mask = scratch.mask.data();
+        std::vector < pb::IntRect >& rects = aabbVec->at(tile / 47)[tile % 47];
+        rects.clear();
+        // Greedy decomposition: grow each rect right as far as possible, then down while the whole span stays solid.
+        // Covered pixels are cleared from the mask so rects never overlap.
+        for (unsigned int y = 0; y < h; ++y) {
+            for (unsigned int x = 0; x < w; ++x) {
+                if(!mask[y * w + x])
+                    continue;
+                unsigned int x2 = x + 1,
+                             y2 = y + 1;
+                while((x2 < w) && mask[y * w + x2])
+                    ++x2;
+                while((y2 < h) && (std::find(mask + y2 * w + x, mask + y2 * w + x2, 0) == mask + y2 * w + x2))
+                    ++y2;
+                for (unsigned int cy = y; cy < y2; ++cy)
+                    std::fill(mask + cy * w + x, mask + cy * w + x2, 0);
+                rects.push_back(pb::IntRect(x, y, x2 - x, y2 - y));
+                x = x2 - 1;
+            }
+        }
+    });
+}
+
+// Marching squares case of a pixel corner: 1 = top-left, 2 = top-right, 4 = bottom-left and 8 = bottom-right pixel are solid
+static const bool cornerCase[16] = {false, true, true, false, true, false, true, true, true, true, false, true, false, true, true, false};
+
+void pb::AutoboxGenerator::generateContours(PointVectorRaw* pointVec, EdgeVectorRaw* edgeVec) const {
+    while(pointVec->size() < idCount())
+        pointVec->push_back(std::vector < std::vector < pb::Vector2i > >(47, std::vector < pb::Vector2i >()));
+    while(edgeVec->size() < idCount())
+        edgeVec->push_back(std::vector < std::vector < pb::IntRect > >(47, std::vector < pb::IntRect >()));
+
+    int w = resolution.x,
+        h = resolution.y;
+    forEachTile([&](size_t tile, TileScratch& scratch) {
+        const unsigned char* mask = scratch.mask.data();
+        std::vector < pb::Vector2i >& points = pointVec->at(tile / 47)[tile % 47];
+        std::vector < pb::IntRect >& edges = edgeVec->at(tile / 47)[tile % 47];
+        points.clear();
+        edges.clear();
+
+        // Classify every pixel corner
+        scratch.cases.resize((w + 1) * (h + 1));
+        unsigned char* cases = scratch.cases.data();
+        for (int y = 0; y <= h; ++y) {
+            for (int x = 0; x <= w; ++x) {
+                bool top = (y > 0),
+                     bottom = (y < h),
+                     left = (x > 0),
+                     right = (x < w);
+                cases[y * (w + 1) + x] = ((top && left && mask[(y - 1) * w + x - 1]) ? 1 : 0) |
+                                         ((top && right && mask[(y - 1) * w + x]) ? 2 : 0) |
+                                         ((bottom && left && mask[y * w + x - 1]) ? 4 : 0) |
+                                         ((bottom && right && mask[y * w + x]) ? 8 : 0);
+            }
+        }
+
+        // Corners
+        for (int y = 0; y <= h; ++y) {
+            for (int x = 0; x <= w; ++x) {
+                unsigned char c = cases[y * (w + 1) + x];
+                if(!cornerCase[c])
+                    continue;
+                pb::Vector2i found[2];
+                unsigned char foundCount = 1;
+                switch(c) {
+                case 1: case 7: found[0] = pb::Vector2i(x - 1, y - 1); break;
+                case 2: case 11: found[0] = pb::Vector2i(x, y - 1); break;
+                case 4: case 13: found[0] = pb::Vector2i(x - 1, y); break;
+                case 8: case 14: found[0] = pb::Vector2i(x, y); break;
+                case 6: // Saddles are two convex corners
+                    found[0] = pb::Vector2i(x, y - 1);
+                    found[1] = pb::Vector2i(x - 1, y);
+                    foundCount = 2;
+                    break;
+                case 9:
+                    found[0] = pb::Vector2i(x - 1, y - 1);
+                    found[1] = pb::Vector2i(x, y);
+                    foundCount = 2;
+                    break;
+                }
+                for (unsigned char i = 0; i < foundCount; ++i) {
+                    if(std::find(points.begin(), points.end(), found[i]) == points.end())
+                        points.push_back(found[i]);
+                }
+            }
+        }
+
+        // Horizontal edges. A boundary segment separates a solid and an empty pixel; runs of segments only end at corners
+        for (int y = 0; y <= h; ++y) {
+            for (int x = 0; x < w; ++x) {
+                unsigned char c = cases[y * (w + 1) + x + 1];
+                if(!(((c >> 2) ^ c) & 1)) // Pixels above and below this segment (top-left and bottom-left of its right corner) differ?
+                    continue;
+                int x2 = x + 1;
+                while((x2 < w) && !cornerCase[cases[y * (w + 1) + x2]])
+                    ++x2;
+                edges.push_back(pb::IntRect(x, y, x2, y));
+                x = x2 - 1;
+            }
+        }
+
+        // Vertical edges
+        for (int x = 0; x <= w; ++x) {
+            for (int y = 0; y < h; ++y) {
+                unsigned char c = cases[(y + 1) * (w + 1) + x];
+                if(!(((c >> 1) ^ c) & 1)) // Pixels left and right of this segment (top-left and top-right of its bottom corner) differ?
+                    continue;
+                int y2 = y + 1;
+                while((y2 < h) && !cornerCase[cases[y2 * (w + 1) + x]])
+                    ++y2;
+                edges.push_back(pb::IntRect(x, y, x, y2));
+                y = y2 - 1;
+            }
+        }
+    });
+}
+
+pb::AutoboxGenerator::AutoboxGenerator(const unsigned char* p_pixels, pb::Vector2u p_size, pb::Vector2u p_resolution, unsigned char p_alphaThreshold, unsigned int p_threads) :
+    pixels(p_pixels),
+    size(p_size),
+    resolution(p_resolution),
+    alphaThreshold(p_alphaThreshold),
+    threads(p_threads)
+{ }
@@ -0,0 +1,46 @@
+#ifndef AUTOBOX_INCLUDED
+#define AUTOBOX_INCLUDED
+
+/*
+    Automatic pointybox generation from a tileset image.
+    The image is sliced into tiles of the current resolution, read row by row, left to right.
+    Tile n of the image is bitmask (n % 47) of tile ID (n / 47), so a tileset with 47 tiles per row has one tile ID per row.
+    A pixel is solid if its alpha is at least the alpha threshold.
+    Contours are found with marching squares over the pixel corners of each tile (pixels outside the tile count as empty):
+        - Edges are maximal axis aligned runs of the solid/empty boundary, stored like the editor stores them (left, top, right, bottom).
+        - Points are the pixels at each contour corner: the solid pixel of a convex corner, or the solid pixel opposite the empty one of a concave corner.
+    Tiles are processed in parallel; each tile only writes to its own (id, bitmask) slot.
+*/
+
+#include <functional>
+#include "pointybox.hpp"
+#include "pool.hpp"
+
+namespace pb {
+    class AutoboxGenerator {
+        const unsigned char* pixels;    // RGBA8 pixels, as given by sf::Image::getPixelsPtr
+        Vector2u size,                  // Image size in pixels
+                 resolution;            // Tile size in pixels
+        unsigned char alphaThreshold;   // Minimum alpha of a solid pixel
+        unsigned int threads;           // Worker thread count (0 = WorkerPool::shared())
+
+        // Per-thread buffers, reused for every tile a worker processes
+        struct TileScratch {
+            std::vector < unsigned char > mask,     // resolution.x * resolution.y solid flags
+                                          cases;    // (resolution.x + 1) * (resolution.y + 1) marching squares cases
+        };
+
+        void maskImage(std::vector < unsigned char >* imageMask) const;                             // Solid flags of every pixel in the tiled area
+        void buildMask(size_t tile, const unsigned char* imageMask, unsigned char* mask) const;     // Slices one tile out of the image mask
+        void forEachTile(const std::function < void(size_t tile, TileScratch& scratch) >& func) const;
+
+    public:
+        size_t tileCount() const;
+        size_t idCount() const;
+        void generateAABBs(AABBVectorRaw* aabbVec) const;
+        void generateContours(PointVectorRaw* pointVec, EdgeVectorRaw* edgeVec) const;
+        AutoboxGenerator(const unsigned char* p_pixels, Vector2u p_size, Vector2u p_resolution, unsigned char p_alphaThreshold = 128, unsigned int p_threads = 0);
+    };
+}
+
+#endif
@@ -0,0 +1,298 @@
+#include "bake.hpp"
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    struct CacheHeader {
+        char magic[4];      // "PBLC"
+        uint32_t version;
+        uint64_t key;
+        uint32_t resX,
+                 resY;
+        uint64_t pointCount,
+                 edgeCount;
+    };
+
+    const uint32_t cacheVersion = 2;
+
+    // FNV-1a
+    uint64_t hashInt(uint64_t hash, int64_t value) {
+        for (unsigned char i = 0; i < 8; ++i) {
+            hash ^= (uint64_t(value) >> (i * 8)) & 0xff;
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // Packs two coordinates into a key which sorts by major, then minor
+    uint64_t pack(int32_t major, int32_t minor) {
+        return (uint64_t(uint32_t(major) ^ 0x80000000u) << 32) | (uint32_t(minor) ^ 0x80000000u);
+    }
+
+    int32_t unpackMajor(uint64_t packed) {
+        return int32_t(uint32_t(packed >> 32) ^ 0x80000000u);
+    }
+
+    int32_t unpackMinor(uint64_t packed) {
+        return int32_t(uint32_t(packed) ^ 0x80000000u);
+    }
+
+    // Drops unit segments found more than once (shared by two tiles) and merges the rest into runs
+    void mergeSegments(std::vector < uint64_t >* segments, bool xAligned, std::vector < pb::BakedEdge >* edges) {
+        std::sort(segments->begin(), segments->end());
+        bool open = false;
+        pb::BakedEdge run = {0, 0, 0, xAligned};
+        for (size_t i = 0; i < segments->size(); ) {
+            size_t j = i + 1;
+            while((j < segments->size()) && ((*segments)[j] == (*segments)[i]))
+                ++j;
+            if(j - i == 1) {
+                int32_t a = unpackMajor((*segments)[i]),
+                        s = unpackMinor((*segments)[i]);
+                if(open && (run.a == a) && (run.b == s))
+                    run.b = s + 1;
+                else {
+                    if(open)
+                        edges->push_back(run);
+                    run.a = a;
+                    run.s = s;
+                    run.b = s + 1;
+                    open = true;
+                }
+            }
+            i = j;
+        }
+        if(open)
+            edges->push_back(run);
+    }
+
+    // Is a point pixel at one of a merged edge run's ends? The pixel touches 4 lattice corners, any of which may be the end
+    bool atRunEnd(uint64_t pixel, const std::vector < uint64_t >& runEnds) {
+        int32_t y = unpackMajor(pixel),
+                x = unpackMinor(pixel);
+        for (unsigned char corner = 0; corner < 4; ++corner) {
+            if(std::binary_search(runEnds.begin(), runEnds.end(), pack(y + (corner >> 1), x + (corner & 1))))
+                return true;
+        }
+        return false;
+    }
+}
+
+uint64_t pb::BakedLighting::computeKey(pb::Vector2u p_resolution, const PointVectorRaw* pointVec, const EdgeVectorRaw* edgeVec, const MapGrid* grid) {
+    uint64_t hash = 14695981039346656037ull;
+    hash = hashInt(hash, cacheVersion);
+    hash = hashInt(hash, p_resolution.x);
+    hash = hashInt(hash, p_resolution.y);
+    hash = hashInt(hash, pointVec->size());
+    for (size_t id = 0; id < pointVec->size(); ++id) {
+        for (size_t bitmask = 0; bitmask < 47; ++bitmask) {
+            const std::vector < pb::Vector2i >& points = pointVec->at(id)[bitmask];
+            hash = hashInt(hash, points.size());
+            for (size_t i = 0; i < points.size(); ++i) {
+                hash = hashInt(hash, points[i].x);
+                hash = hashInt(hash, points[i].y);
+            }
+        }
+    }
+    hash = hashInt(hash, edgeVec->size());
+    for (size_t id = 0; id < edgeVec->size(); ++id) {
+        for (size_t bitmask = 0; bitmask < 47; ++bitmask) {
+            const std::vector < pb::IntRect >& edges = edgeVec->at(id)[bitmask];
+            hash = hashInt(hash, edges.size());
+            for (size_t i = 0; i < edges.size(); ++i) {
+                hash = hashInt(hash, edges[i].left);
+                hash = hashInt(hash, edges[i].top);
+                hash = hashInt(hash, edges[i].width);
+                hash = hashInt(hash, edges[i].height);
+            }
+        }
+    }
+    hash = hashInt(hash, grid->width);
+    hash = hashInt(hash, grid->height);
+    for (size_t i = 0; i < size_t(grid->width) * grid->height; ++i) {
+        hash = hashInt(hash, grid->ids[i]);
+        hash = hashInt(hash, grid->bitmasks[i]);
+    }
+    return hash;
+}
+
+void pb::BakedLighting::bake(pb::Vector2u p_resolution, const PointVectorRaw* pointVec, const EdgeVectorRaw* edgeVec, const MapGrid* grid) {
+    unmap();
+    resolution = p_resolution;
+    key = computeKey(p_resolution, pointVec, edgeVec, grid);
+    ownPoints.clear();
+    ownEdges.clear();
+
+    std::vector < uint64_t > cornerKeys,
+                             hSegments,     // Y aligned unit segments, (y, x)
+                             vSegments;     // X aligned unit segments, (x, y)
+    for (unsigned int cy = 0; cy < grid->height; ++cy) {
+        for (unsigned int cx = 0; cx < grid->width; ++cx) {
+            int32_t id = grid->ids[cy * grid->width + cx];
+            uint8_t bitmask = grid->bitmasks[cy * grid->width + cx];
+            if((id < 0) || (bitmask >= 47))
+                continue;
+            int32_t ox = cx * resolution.x,
+                    oy = cy * resolution.y;
+
+            if(size_t(id) < pointVec->size()) {
+                const std::vector < pb::Vector2i >& points = pointVec->at(id)[bitmask];
+                for (size_t i = 0; i < points.size(); ++i)
+                    cornerKeys.push_back(pack(oy + points[i].y, ox + points[i].x));
+            }
+
+            if(size_t(id) < edgeVec->size()) {
+                const std::vector < pb::IntRect >& edges = edgeVec->at(id)[bitmask];
+                for (size_t i = 0; i < edges.size(); ++i) {
+                    const pb::IntRect& edge = edges[i];
+                    if((edge.left == edge.width) && (edge.top != edge.height)) {
+                        for (int32_t y = std::min(edge.top, edge.height); y < std::max(edge.top, edge.height); ++y)
+                            vSegments.push_back(pack(ox + edge.left, oy + y));
+                    }
+                    else if((edge.top == edge.height) && (edge.left != edge.width)) {
+                        for (int32_t x = std::min(edge.left, edge.width); x < std::max(edge.left, edge.width); ++x)
+                            hSegments.push_back(pack(oy + edge.top, ox + x));
+                    }
+                }
+            }
+        }
+    }
+
+    mergeSegments(&hSegments, false, &ownEdges);
+    mergeSegments(&vSegments, true, &ownEdges);
+
+    // Corners on seams between tiles stop being corners once their edges are dropped, so only keep points at the ends of the merged runs
+    std::vector < uint64_t > runEnds;   // (y, x) lattice corners
+    for (size_t i = 0; i < ownEdges.size(); ++i) {
+        const BakedEdge& edge = ownEdges[i];
+        runEnds.push_back(edge.x ? pack(edge.s, edge.a) : pack(edge.a, edge.s));
+        runEnds.push_back(edge.x ? pack(edge.b, edge.a) : pack(edge.a, edge.b));
+    }
+    std::sort(runEnds.begin(), runEnds.end());
+    std::sort(cornerKeys.begin(), cornerKeys.end());
+    cornerKeys.erase(std::unique(cornerKeys.begin(), cornerKeys.end()), cornerKeys.end());
+    for (size_t i = 0; i < cornerKeys.size(); ++i) {
+        if(!atRunEnd(cornerKeys[i], runEnds))
+            continue;
+        BakedPoint point = {unpackMinor(cornerKeys[i]), unpackMajor(cornerKeys[i])};
+        ownPoints.push_back(point);
+    }
+
+    points = ownPoints.data();
+    pointCount = ownPoints.size();
+    edges = ownEdges.data();
+    edgeCount = ownEdges.size();
+}
+
+bool pb::BakedLighting::save(const std::string& path) const {
+    std::ofstream fs(path, std::fstream::out | std::fstream::binary);
+    if(!fs)
+        return false;
+    CacheHeader header = {{'P', 'B', 'L', 'C'}, cacheVersion, key, resolution.x, resolution.y, pointCount, edgeCount};
+    fs.write(reinterpret_cast < const char* >(&header), sizeof(header));
+    fs.write(reinterpret_cast < const char* >(points), pointCount * sizeof(BakedPoint));
+    fs.write(reinterpret_cast < const char* >(edges), edgeCount * sizeof(BakedEdge));
+    fs.close();
+    return !fs.fail();
+}
+
+bool pb::BakedLighting::map(const std::string& path, uint64_t expectedKey) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0)
+        return false;
+    struct stat st;
+    if((fstat(fd, &st) != 0) || (size_t(st.st_size) < sizeof(CacheHeader))) {
+        close(fd);
+        return false;
+    }
+    size_t size = st.st_size;
+    void* data = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(data == MAP_FAILED)
+        return false;
+
+    const CacheHeader* header = static_cast < const CacheHeader* >(data);
+    if((memcmp(header->magic, "PBLC", 4) != 0) || (header->version != cacheVersion) || (header->key != expectedKey) ||
+       (size != sizeof(CacheHeader) + header->pointCount * sizeof(BakedPoint) + header->edgeCount * sizeof(BakedEdge))) {
+        munmap(data, size);
+        return false;
+    }
+
+    unmap();
+    ownPoints.clear();
+    ownEdges.clear();
+    mapping = data;
+    mappingSize = size;
+    resolution = pb::Vector2u(header->resX, header->resY);
+    key = header->key;
+    pointCount = header->pointCount;
+    edgeCount = header->edgeCount;
+    points = reinterpret_cast < const BakedPoint* >(header + 1);
+    edges = reinterpret_cast < const BakedEdge* >(points + pointCount);
+    return true;
+}
+
+bool pb::BakedLighting::loadOrBake(const std::string& path, pb::Vector2u p_resolution, const PointVectorRaw* pointVec, const EdgeVectorRaw* edgeVec, const MapGrid* grid) {
+    if(map(path, computeKey(p_resolution, pointVec, edgeVec, grid)))
+        return true;
+    bake(p_resolution, pointVec, edgeVec, grid);
+    save(path);
+    return false;
+}
+
+void pb::BakedLighting::unmap() {
+    if(mapping)
+        munmap(mapping, mappingSize);
+    mapping = 0;
+    mappingSize = 0;
+    points = 0;
+    edges = 0;
+    pointCount = 0;
+    edgeCount = 0;
+}
+
+uint64_t pb::BakedLighting::getKey() const {
+    return key;
+}
+
+pb::Vector2u pb::BakedLighting::getResolution() const {
+    return resolution;
+}
+
+pb::Span < pb::BakedPoint > pb::BakedLighting::getRawPoints() const {
+    return Span < BakedPoint >(points, points + pointCount);
+}
+
+pb::Span < pb::BakedEdge > pb::BakedLighting::getRawEdges() const {
+    return Span < BakedEdge >(edges, edges + edgeCount);
+}
+
+pb::Vector2f pb::BakedLighting::getPoint(size_t i) const {
+    return pb::Vector2f((0.5f + float(points[i].x)) / float(resolution.x),
+                        (0.5f + float(points[i].y)) / float(resolution.y));
+}
+
+pb::AALine pb::BakedLighting::getEdge(size_t i) const {
+    const BakedEdge& edge = edges[i];
+    float aRes = float(edge.x ? resolution.x : resolution.y),
+          sbRes = float(edge.x ? resolution.y : resolution.x);
+    return AALine(edge.x != 0, float(edge.a) / aRes, float(edge.s) / sbRes, float(edge.b) / sbRes);
+}
+
+pb::BakedLighting::BakedLighting() :
+    resolution(1, 1),
+    key(0),
+    points(0),
+    edges(0),
+    pointCount(0),
+    edgeCount(0),
+    mapping(0),
+    mappingSize(0)
+{ }
+
+pb::BakedLighting::~BakedLighting() {
+    unmap();
+}
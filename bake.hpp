@@ -0,0 +1,71 @@
+#ifndef BAKE_INCLUDED
+#define BAKE_INCLUDED
+
+/*
+    Baked world-space lighting geometry.
+    Baking places every map cell's tile points and edges in the world and cleans them up:
+        - Edges (or parts of edges) lying between two tiles are interior and dropped; the rest is merged back into maximal axis aligned runs.
+        - Points are only kept where they sit at an end of one of those runs, so corners on seams between tiles go away with their edges. Duplicates are kept once.
+    Everything is kept in world pixel coordinates (cell * resolution + tile coordinate), so it is exact; use getPoint/getEdge for world tile units like parse() gives.
+    Results can be saved to a cache file keyed by a hash of the pointybox point/edge data, the resolution and the map grid. Mapping a cache with a matching key uses the file in place (mmap) instead of baking.
+*/
+
+#include "pointybox.hpp"
+
+namespace pb {
+    struct MapGrid {
+        unsigned int width,
+                     height;
+        std::vector < int32_t > ids;        // Tile ID of each cell, row by row. Negative for empty cells
+        std::vector < uint8_t > bitmasks;   // Bitmask of each cell
+    };
+
+    struct BakedPoint {
+        int32_t x,          // World pixel
+                y;
+    };
+
+    struct BakedEdge {
+        int32_t a,          // Same meaning as AALine, in world pixel corners
+                s,
+                b;
+        uint32_t x;         // Is the line X aligned?
+    };
+
+    class BakedLighting {
+        Vector2u resolution;
+        uint64_t key;
+        std::vector < BakedPoint > ownPoints;   // Storage when baked in memory
+        std::vector < BakedEdge > ownEdges;
+        const BakedPoint* points;               // Either the vectors above or the mapped file
+        const BakedEdge* edges;
+        size_t pointCount,
+               edgeCount;
+        void* mapping;
+        size_t mappingSize;
+
+        void unmap();
+
+    public:
+        static uint64_t computeKey(Vector2u p_resolution, const PointVectorRaw* pointVec, const EdgeVectorRaw* edgeVec, const MapGrid* grid);
+
+        void bake(Vector2u p_resolution, const PointVectorRaw* pointVec, const EdgeVectorRaw* edgeVec, const MapGrid* grid);
+        bool save(const std::string& path) const;
+        bool map(const std::string& path, uint64_t expectedKey);    // False if the file is missing, invalid or has another key
+        bool loadOrBake(const std::string& path, Vector2u p_resolution, const PointVectorRaw* pointVec, const EdgeVectorRaw* edgeVec, const MapGrid* grid); // Returns whether the cache was used
+
+        uint64_t getKey() const;
+        Vector2u getResolution() const;
+        Span < BakedPoint > getRawPoints() const;
+        Span < BakedEdge > getRawEdges() const;
+        Vector2f getPoint(size_t i) const;
+        AALine getEdge(size_t i) const;
+
+        BakedLighting();
+        BakedLighting(const BakedLighting&) = delete;
+        BakedLighting& operator=(const BakedLighting&) = delete;
+        ~BakedLighting();
+    };
+}
+
+#endif
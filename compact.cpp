@@ -0,0 +1,172 @@
+#include "compact.hpp"
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+template < typename T >
+bool pb::CompactGeometry < T >::fill(pb::Vector2u p_resolution, AABBVectorRaw* aabbVec, PointVectorRaw* pointVec, EdgeVectorRaw* edgeVec) {
+    const int maxVal = std::numeric_limits < T >::max();
+    if((p_resolution.x < 1) || (p_resolution.y < 1) || (p_resolution.x > unsigned(maxVal)) || (p_resolution.y > unsigned(maxVal)))
+        return false;
+    resolution = p_resolution;
+    ids = std::max(aabbVec->size(), std::max(pointVec->size(), edgeVec->size()));
+
+    aabbStart.assign(1, 0);
+    pointStart.assign(1, 0);
+    edgeStart.assign(1, 0);
+    aabbX1.clear(); aabbY1.clear(); aabbX2.clear(); aabbY2.clear();
+    pointX.clear(); pointY.clear();
+    edgeA.clear(); edgeS.clear(); edgeB.clear();
+    edgeXBits.clear();
+
+    for (size_t id = 0; id < ids; ++id) {
+        for (size_t bitmask = 0; bitmask < 47; ++bitmask) {
+            if(id < aabbVec->size()) {
+                const std::vector < pb::IntRect >& rects = aabbVec->at(id)[bitmask];
+                for (size_t i = 0; i < rects.size(); ++i) {
+                    int x2 = rects[i].left + rects[i].width,
+                        y2 = rects[i].top + rects[i].height;
+                    if((rects[i].left < 0) || (rects[i].top < 0) || (rects[i].width < 0) || (rects[i].height < 0) || (x2 > maxVal) || (y2 > maxVal))
+                        return false;
+                    aabbX1.push_back(T(rects[i].left));
+                    aabbY1.push_back(T(rects[i].top));
+                    aabbX2.push_back(T(x2));
+                    aabbY2.push_back(T(y2));
+                }
+            }
+            aabbStart.push_back(aabbX1.size());
+
+            if(id < pointVec->size()) {
+                const std::vector < pb::Vector2i >& points = pointVec->at(id)[bitmask];
+                for (size_t i = 0; i < points.size(); ++i) {
+                    if((points[i].x < 0) || (points[i].y < 0) || (points[i].x > maxVal) || (points[i].y > maxVal))
+                        return false;
+                    pointX.push_back(T(points[i].x));
+                    pointY.push_back(T(points[i].y));
+                }
+            }
+            pointStart.push_back(pointX.size());
+
+            if(id < edgeVec->size()) {
+                const std::vector < pb::IntRect >& edges = edgeVec->at(id)[bitmask];
+                for (size_t i = 0; i < edges.size(); ++i) {
+                    // Same rules as parse: axis aligned and not a point
+                    bool xAligned;
+                    if(edges[i].left == edges[i].width)
+                        xAligned = true;
+                    else if(edges[i].top == edges[i].height)
+                        xAligned = false;
+                    else
+                        return false;
+                    if((edges[i].left < 0) || (edges[i].top < 0) || (edges[i].width < 0) || (edges[i].height < 0) ||
+                       (edges[i].left > maxVal) || (edges[i].top > maxVal) || (edges[i].width > maxVal) || (edges[i].height > maxVal))
+                        return false;
+                    if(xAligned) {
+                        if(edges[i].top == edges[i].height)
+                            return false;
+                        edgeA.push_back(T(edges[i].left));
+                        edgeS.push_back(T(edges[i].top));
+                        edgeB.push_back(T(edges[i].height));
+                    }
+                    else {
+                        edgeA.push_back(T(edges[i].top));
+                        edgeS.push_back(T(edges[i].left));
+                        edgeB.push_back(T(edges[i].width));
+                    }
+                    size_t n = edgeA.size() - 1;
+                    if((n % 32) == 0)
+                        edgeXBits.push_back(0);
+                    if(xAligned)
+                        edgeXBits[n / 32] |= (uint32_t(1) << (n % 32));
+                }
+            }
+            edgeStart.push_back(edgeA.size());
+        }
+    }
+    return true;
+}
+
+template < typename T >
+bool pb::CompactGeometry < T >::build(pb::Vector2u p_resolution, AABBVectorRaw* aabbVec, PointVectorRaw* pointVec, EdgeVectorRaw* edgeVec) {
+    // Built aside so a rejected input can't leave ids and the offset tables out of step
+    CompactGeometry < T > built;
+    if(!built.fill(p_resolution, aabbVec, pointVec, edgeVec))
+        return false;
+    *this = std::move(built);
+    return true;
+}
+
+template < typename T >
+size_t pb::CompactGeometry < T >::memoryUsage() const {
+    return sizeof(*this) +
+           (aabbStart.capacity() + pointStart.capacity() + edgeStart.capacity() + edgeXBits.capacity()) * sizeof(uint32_t) +
+           (aabbX1.capacity() + aabbY1.capacity() + aabbX2.capacity() + aabbY2.capacity() +
+            pointX.capacity() + pointY.capacity() +
+            edgeA.capacity() + edgeS.capacity() + edgeB.capacity()) * sizeof(T);
+}
+
+template < typename T >
+size_t pb::CompactGeometry < T >::idCount() const {
+    return ids;
+}
+
+template < typename T >
+size_t pb::CompactGeometry < T >::aabbCount(size_t id, size_t bitmask) const {
+    return aabbStart[id * 47 + bitmask + 1] - aabbStart[id * 47 + bitmask];
+}
+
+template < typename T >
+size_t pb::CompactGeometry < T >::pointCount(size_t id, size_t bitmask) const {
+    return pointStart[id * 47 + bitmask + 1] - pointStart[id * 47 + bitmask];
+}
+
+template < typename T >
+size_t pb::CompactGeometry < T >::edgeCount(size_t id, size_t bitmask) const {
+    return edgeStart[id * 47 + bitmask + 1] - edgeStart[id * 47 + bitmask];
+}
+
+template < typename T >
+pb::RangeRect pb::CompactGeometry < T >::getAABB(size_t id, size_t bitmask, size_t i) const {
+    size_t n = aabbStart[id * 47 + bitmask] + i;
+    return RangeRect(float(aabbX1[n]) / float(resolution.x), float(aabbY1[n]) / float(resolution.y), float(aabbX2[n]) / float(resolution.x), float(aabbY2[n]) / float(resolution.y));
+}
+
+template < typename T >
+pb::Vector2f pb::CompactGeometry < T >::getPoint(size_t id, size_t bitmask, size_t i) const {
+    size_t n = pointStart[id * 47 + bitmask] + i;
+    return pb::Vector2f((0.5f + float(pointX[n])) / float(resolution.x), (0.5f + float(pointY[n])) / float(resolution.y));
+}
+
+template < typename T >
+pb::AALine pb::CompactGeometry < T >::getEdge(size_t id, size_t bitmask, size_t i) const {
+    size_t n = edgeStart[id * 47 + bitmask] + i;
+    bool xAligned = (edgeXBits[n / 32] >> (n % 32)) & 1;
+    float aRes = float(xAligned ? resolution.x : resolution.y),  // Decoded with a division, like parse, so results match it exactly
+          sbRes = float(xAligned ? resolution.y : resolution.x);
+    return AALine(xAligned, float(edgeA[n]) / aRes, float(edgeS[n]) / sbRes, float(edgeB[n]) / sbRes);
+}
+
+template < typename T >
+bool pb::CompactGeometry < T >::contains(size_t id, size_t bitmask, float x, float y) const {
+    // Compare in fixed-point space so the stored values never need decoding
+    float qx = x * resolution.x,
+          qy = y * resolution.y;
+    size_t end = aabbStart[id * 47 + bitmask + 1];
+    for (size_t n = aabbStart[id * 47 + bitmask]; n < end; ++n) {
+        if((qx >= aabbX1[n]) && (qx <= aabbX2[n]) && (qy >= aabbY1[n]) && (qy <= aabbY2[n]))
+            return true;
+    }
+    return false;
+}
+
+template < typename T >
+pb::CompactGeometry < T >::CompactGeometry() :
+    resolution(1, 1),
+    ids(0),
+    aabbStart(1, 0),
+    pointStart(1, 0),
+    edgeStart(1, 0)
+{ }
+
+template class pb::CompactGeometry < uint8_t >;
+template class pb::CompactGeometry < uint16_t >;
@@ -0,0 +1,54 @@
+#ifndef COMPACT_INCLUDED
+#define COMPACT_INCLUDED
+
+/*
+    Compact pointybox geometry.
+    Holds the same data parse() produces, but quantized and laid out as structures of arrays:
+        - Coordinates are kept as unsigned fixed-point values relative to the resolution (value / resolution), exactly like the raw file data, so nothing is lost.
+        - AALine orientations are packed into a bit set.
+        - Each kind of data is stored in flat arrays, with one offset per (id, bitmask) slot instead of a vector per slot.
+    Values are decoded when queried. Use CompactGeometry8 for resolutions up to 255 and CompactGeometry16 for up to 65535.
+*/
+
+#include <stdint.h>
+#include "pointybox.hpp"
+
+namespace pb {
+    template < typename T >
+    class CompactGeometry {
+        Vector2u resolution;
+        size_t ids;
+        // Slot s = id * 47 + bitmask owns [start[s], start[s + 1]) of its arrays
+        std::vector < uint32_t > aabbStart,
+                                 pointStart,
+                                 edgeStart;
+        std::vector < T > aabbX1, aabbY1, aabbX2, aabbY2,
+                          pointX, pointY,
+                          edgeA, edgeS, edgeB;
+        std::vector < uint32_t > edgeXBits; // Bit i set if edge i is X aligned
+
+        bool fill(Vector2u p_resolution, AABBVectorRaw* aabbVec, PointVectorRaw* pointVec, EdgeVectorRaw* edgeVec);
+
+    public:
+        bool build(Vector2u p_resolution, AABBVectorRaw* aabbVec, PointVectorRaw* pointVec, EdgeVectorRaw* edgeVec); // Leaves the geometry unchanged on failure
+        size_t memoryUsage() const;
+
+        size_t idCount() const;
+        size_t aabbCount(size_t id, size_t bitmask) const;
+        size_t pointCount(size_t id, size_t bitmask) const;
+        size_t edgeCount(size_t id, size_t bitmask) const;
+
+        RangeRect getAABB(size_t id, size_t bitmask, size_t i) const;
+        Vector2f getPoint(size_t id, size_t bitmask, size_t i) const;
+        AALine getEdge(size_t id, size_t bitmask, size_t i) const;
+        bool contains(size_t id, size_t bitmask, float x, float y) const; // Is (x, y) (in tile units) inside any of the slot's AABBs?
+
+        CompactGeometry();
+    };
+
+    // Instantiated in compact.cpp
+    typedef CompactGeometry < uint8_t > CompactGeometry8;
+    typedef CompactGeometry < uint16_t > CompactGeometry16;
+}
+
+#endif
@@ -1,27 +1,39 @@
 #!/bin/bash
 #Set additional options for compiling and running.
-sources="./pointybox.cpp"
-options="-Wall -Wno-switch -O3 -pipe -std=c++11 -lsfml-system -lsfml-window -lsfml-graphics"
+#Core sources are built into ./bin/libpointybox.a, which doesn't depend on SFML. Headless tools only need to link against it (and -pthread).
+core="./pointybox.cpp ./arena.cpp ./pool.cpp ./asyncload.cpp ./autobox.cpp ./compact.cpp ./watcher.cpp ./raycast.cpp ./occupancy.cpp ./bake.cpp ./trace.cpp"
+sources=""
+#Set trace to "-DPB_TRACE" to record a Chrome trace of loading and editing (see trace.hpp). It must apply to every source, so it goes in coreoptions.
+trace=""
+coreoptions="$trace -Wall -Wno-switch -O3 -pipe -std=c++11 -pthread"
+options="$coreoptions -lsfml-system -lsfml-window -lsfml-graphics"
 #Display g++ version before building
 s1="Building using $(g++ --version | grep --color=never "g++")"
-s2="Sources: $sources"
-s3="Options: $options"
+s2="Core sources: $core"
+s3="Sources: $sources"
+s4="Options: $options"
 
 w=${#s1}
-if [ ${#s2} -gt $w ]; then
-    w=${#s2}
-fi
-if [ ${#s3} -gt $w ]; then
-    w=${#s3}
-fi
+for s in "$s2" "$s3" "$s4"; do
+    if [ ${#s} -gt $w ]; then
+        w=${#s}
+    fi
+done
 
-printf "$s1\n$s2\n$s3\n"
+printf "$s1\n$s2\n$s3\n$s4\n"
 for (( x=0; x < $w; x++)); do
     printf "-"
 done
 printf "\n"
+#Build the core library.
+mkdir -p "./bin/core"
+rm -f ./bin/core/*.o "./bin/libpointybox.a"
+for src in $core; do
+    g++ -c "$src" $coreoptions -o "./bin/core/$(basename "$src" .cpp).o" || { echo Core build failed!; exit 1; }
+done
+ar rcs "./bin/libpointybox.a" ./bin/core/*.o || { echo Core build failed!; exit 1; }
 #Build the project with current directory and additional user options. Project must have a main.cpp file as the main source.
-g++ "./main.cpp" $sources $options -o "./bin/sublime_out"
+g++ "./main.cpp" $sources "./bin/libpointybox.a" $options -o "./bin/sublime_out"
 #Get exitcode for later use.
 exitcode=$?
 if [ $exitcode -ne 0 ];then #If the exitcode is not equal to 0 (EXIT_SUCCESS) then it failed.
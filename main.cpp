@@ -7,12 +7,15 @@
 */
 
 #include "pointybox.hpp"
+#include "pointybox_sfml.hpp"
+#include "autobox.hpp"
+#include "trace.hpp"
 #include <iostream>
 #include <math.h>
 
-void renderPointMode(sf::VertexArray* pointyboxVA, std::vector < sf::Vector2i >* pointVec, sf::Color pointColor, float& zoom) {
+void renderPointMode(sf::VertexArray* pointyboxVA, std::vector < pb::Vector2i >* pointVec, sf::Color pointColor, float& zoom) {
     for(size_t i = 0; i < pointVec->size(); ++i) {
-        sf::Vector2i pos = pointVec->at(i);
+        pb::Vector2i pos = pointVec->at(i);
         pointyboxVA->append(sf::Vertex(sf::Vector2f(pos.x * zoom, pos.y * zoom), pointColor));
         pointyboxVA->append(sf::Vertex(sf::Vector2f((pos.x + 1) * zoom, pos.y * zoom), pointColor));
         pointyboxVA->append(sf::Vertex(sf::Vector2f((pos.x + 1) * zoom, (pos.y + 1) * zoom), pointColor));
@@ -20,9 +23,9 @@ void renderPointMode(sf::VertexArray* pointyboxVA, std::vector < sf::Vector2i >*
     }
 }
 
-void renderAABBMode(sf::VertexArray* pointyboxVA, std::vector < sf::IntRect >* aabbVec, sf::Color aabbColor, float& zoom) {
+void renderAABBMode(sf::VertexArray* pointyboxVA, std::vector < pb::IntRect >* aabbVec, sf::Color aabbColor, float& zoom) {
     for(size_t i = 0; i < aabbVec->size(); ++i) {
-        sf::IntRect pos = aabbVec->at(i);
+        pb::IntRect pos = aabbVec->at(i);
         pointyboxVA->append(sf::Vertex(sf::Vector2f(pos.left * zoom, pos.top * zoom), aabbColor));
         pointyboxVA->append(sf::Vertex(sf::Vector2f((pos.left + pos.width) * zoom, pos.top * zoom), aabbColor));
         pointyboxVA->append(sf::Vertex(sf::Vector2f((pos.left + pos.width) * zoom, (pos.top + pos.height) * zoom), aabbColor));
@@ -30,9 +33,9 @@ void renderAABBMode(sf::VertexArray* pointyboxVA, std::vector < sf::IntRect >* a
     }
 }
 
-void renderEdgeMode(sf::VertexArray* pointyboxVA, std::vector < sf::IntRect >* edgeVec, sf::Color edgeColor, float& zoom, char lineThickness) {
+void renderEdgeMode(sf::VertexArray* pointyboxVA, std::vector < pb::IntRect >* edgeVec, sf::Color edgeColor, float& zoom, char lineThickness) {
     for(size_t i = 0; i < edgeVec->size(); ++i) {
-        sf::IntRect pos = edgeVec->at(i);
+        pb::IntRect pos = edgeVec->at(i);
         pointyboxVA->append(sf::Vertex(sf::Vector2f(pos.left * zoom - lineThickness - 1, pos.top * zoom - lineThickness - 1), edgeColor));
         pointyboxVA->append(sf::Vertex(sf::Vector2f(pos.width * zoom + lineThickness, pos.top * zoom - lineThickness - 1), edgeColor));
         pointyboxVA->append(sf::Vertex(sf::Vector2f(pos.width * zoom + lineThickness, pos.height * zoom + lineThickness), edgeColor));
@@ -40,8 +43,8 @@ void renderEdgeMode(sf::VertexArray* pointyboxVA, std::vector < sf::IntRect >* e
     }
 }
 
-sf::IntRect getAABBFromPoints(sf::Vector2i p1, sf::Vector2i p2) {
-    sf::Vector2i tl,
+pb::IntRect getAABBFromPoints(pb::Vector2i p1, pb::Vector2i p2) {
+    pb::Vector2i tl,
                  br;
     if(p1.x > p2.x) {
         tl.x = p2.x;
@@ -59,11 +62,11 @@ sf::IntRect getAABBFromPoints(sf::Vector2i p1, sf::Vector2i p2) {
         tl.y = p1.y;
         br.y = p2.y;
     }
-    return sf::IntRect(tl.x, tl.y, br.x - tl.x + 1, br.y - tl.y + 1);
+    return pb::IntRect(tl.x, tl.y, br.x - tl.x + 1, br.y - tl.y + 1);
 }
 
-sf::IntRect getEdgeFromPoints(sf::Vector2i p1, sf::Vector2i p2) {
-    sf::Vector2i tl,
+pb::IntRect getEdgeFromPoints(pb::Vector2i p1, pb::Vector2i p2) {
+    pb::Vector2i tl,
                  br;
     if(p1.x > p2.x) {
         tl.x = p2.x;
@@ -81,26 +84,76 @@ sf::IntRect getEdgeFromPoints(sf::Vector2i p1, sf::Vector2i p2) {
         tl.y = p1.y;
         br.y = p2.y;
     }
-    return sf::IntRect(tl.x, tl.y, br.x, br.y);
+    return pb::IntRect(tl.x, tl.y, br.x, br.y);
 }
 
-sf::Vector2i snapEdge(sf::Vector2i pos, sf::Vector2i snapTo) {
-    sf::Vector2i dif(snapTo.x - pos.x, snapTo.y - pos.y);
+pb::Vector2i snapEdge(pb::Vector2i pos, pb::Vector2i snapTo) {
+    pb::Vector2i dif(snapTo.x - pos.x, snapTo.y - pos.y);
     if(dif.x < 0)
         dif.x *= -1;
     if(dif.y < 0)
         dif.y *= -1;
     if(dif.x <= dif.y) // Prefer x over y when x == y. Snap to x
-        return sf::Vector2i(snapTo.x, pos.y);
+        return pb::Vector2i(snapTo.x, pos.y);
     else // Snap to y
-        return sf::Vector2i(pos.x, snapTo.y);
+        return pb::Vector2i(pos.x, snapTo.y);
+}
+
+// Keep every vector with the same amount of IDs
+void padIDs(pb::AABBVectorRaw* aabbVec, pb::PointVectorRaw* pointVec, pb::EdgeVectorRaw* edgeVec) {
+    size_t ids = std::max(aabbVec->size(), std::max(pointVec->size(), edgeVec->size()));
+    while(aabbVec->size() < ids)
+        aabbVec->push_back(std::vector < std::vector < pb::IntRect > >(47, std::vector < pb::IntRect >()));
+    while(pointVec->size() < ids)
+        pointVec->push_back(std::vector < std::vector < pb::Vector2i > >(47, std::vector < pb::Vector2i >()));
+    while(edgeVec->size() < ids)
+        edgeVec->push_back(std::vector < std::vector < pb::IntRect > >(47, std::vector < pb::IntRect >()));
+}
+
+void autoGenerateAABBs(sf::Image* image, pb::Vector2u resolution, pb::AABBVectorRaw* aabbVec, pb::PointVectorRaw* pointVec, pb::EdgeVectorRaw* edgeVec) {
+    pb::AutoboxGenerator generator(image->getPixelsPtr(), pb::fromSFML(image->getSize()), resolution);
+    generator.generateAABBs(aabbVec);
+    padIDs(aabbVec, pointVec, edgeVec);
+}
+
+void autoGenerateContours(sf::Image* image, pb::Vector2u resolution, pb::AABBVectorRaw* aabbVec, pb::PointVectorRaw* pointVec, pb::EdgeVectorRaw* edgeVec) {
+    pb::AutoboxGenerator generator(image->getPixelsPtr(), pb::fromSFML(image->getSize()), resolution);
+    generator.generateContours(pointVec, edgeVec);
+    padIDs(aabbVec, pointVec, edgeVec);
 }
 
 int main(int argc, char* argv[]) {
     try {
-        if((argc == 2) || (argc == 3)) {
+        if((argc == 4) && (std::string(argv[1]) == "--generate")) {
+            // Headless generation. Uses the resolution of the existing file, or 8x8 for new files
+            pb::PointyboxLoader ploader(argv[2]);
+            pb::Vector2u resolution(8, 8);
+            pb::AABBVectorRaw aabbVec;
+            pb::PointVectorRaw pointVec;
+            pb::EdgeVectorRaw edgeVec;
+            if (!ploader.load(&resolution, &aabbVec, &pointVec, &edgeVec)) {
+                if(std::ifstream(argv[2])) {
+                    std::cerr << "Error: " << argv[2] << " is not a valid pointybox file!" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                resolution = pb::Vector2u(8, 8);
+                aabbVec.clear();
+                pointVec.clear();
+                edgeVec.clear();
+            }
+            sf::Image image;
+            if(!image.loadFromFile(argv[3])) {
+                std::cerr << "Error: " << argv[3] << " is not a valid texture file!" << std::endl;
+                return EXIT_FAILURE;
+            }
+            autoGenerateAABBs(&image, resolution, &aabbVec, &pointVec, &edgeVec);
+            autoGenerateContours(&image, resolution, &aabbVec, &pointVec, &edgeVec);
+            ploader.save(&resolution, &aabbVec, &pointVec, &edgeVec);
+            std::cout << "Generated pointybox file " << argv[2] << " with " << aabbVec.size() << " tile IDs" << std::endl;
+        }
+        else if((argc == 2) || (argc == 3)) {
             pb::PointyboxLoader ploader(argv[1]);
-            sf::Vector2u resolution(8, 8);        // Current resolution of whole file
+            pb::Vector2u resolution(8, 8);        // Current resolution of whole file
             // Other PB data
             pb::AABBVectorRaw aabbVec;
             pb::PointVectorRaw pointVec;
@@ -115,17 +168,17 @@ int main(int argc, char* argv[]) {
                 if (input != "YES")
                     return EXIT_FAILURE;
                 
-                resolution = sf::Vector2u(8, 8);
+                resolution = pb::Vector2u(8, 8);
                 aabbVec.clear();
                 pointVec.clear();
                 edgeVec.clear();
             }
             if(aabbVec.empty())
-                aabbVec.push_back(std::vector < std::vector < sf::IntRect > >(47, std::vector < sf::IntRect >()));
+                aabbVec.push_back(std::vector < std::vector < pb::IntRect > >(47, std::vector < pb::IntRect >()));
             if(pointVec.empty())
-                pointVec.push_back(std::vector < std::vector < sf::Vector2i > >(47, std::vector < sf::Vector2i >()));
+                pointVec.push_back(std::vector < std::vector < pb::Vector2i > >(47, std::vector < pb::Vector2i >()));
             if(edgeVec.empty())
-                edgeVec.push_back(std::vector < std::vector < sf::IntRect > >(47, std::vector < sf::IntRect >()));
+                edgeVec.push_back(std::vector < std::vector < pb::IntRect > >(47, std::vector < pb::IntRect >()));
 
             // Config and other stuff
             bool drag = false,                              // Dragging?
@@ -144,9 +197,9 @@ int main(int argc, char* argv[]) {
                           thisEdgeThickness = edgeThickness;// Edge line thickness's final value. = edgeThickness * (zoom / 32)
             size_t id = 0;                                  // Selected tile ID
             sf::Vector2i mousePos,                          // Current mouse position
-                         selectedTilePos,                   // Current selected tile position (calculated from mousePos, camPos and zoom)
-                         firstPos,                          // Selected position for first aabb or edge point
                          texSize;                           // Current texture size "offset"
+            pb::Vector2i selectedTilePos,                   // Current selected tile position (calculated from mousePos, camPos and zoom)
+                         firstPos;                          // Selected position for first aabb or edge point
             sf::Vector2f camPos(0.0f, 0.0f),                // Current camera position
                          texCamPos(0.0f, 0.0f);             // Current background image position
                                                             // Colours used for background:
@@ -154,7 +207,7 @@ int main(int argc, char* argv[]) {
                                     sf::Color(127, 127, 127),   // Gray
                                     sf::Color(127, 0  , 127)};  // Purple
                                                             // Strings for help and stats:
-            std::string help = "[Q] Quit; [M] Mode; [Up/Down] Bitmask; [Left/Right] ID; [LMB/RMB] Add/remove; [IJKL] Resolution\nCamera: [F] Fullscreen; [C] BG colour; [WMB drag] Move camera; [T drag] Move texture; [WASD] Texture size; [G] Grid\n",
+            std::string help = "[Q] Quit; [M] Mode; [Up/Down] Bitmask; [Left/Right] ID; [LMB/RMB] Add/remove; [IJKL] Resolution; [B] Auto AABBs; [P] Auto points & edges\nCamera: [F] Fullscreen; [C] BG colour; [WMB drag] Move camera; [T drag] Move texture; [WASD] Texture size; [G] Grid\n",
                         modeInfo[3] = {"AABBs",
                                        "Points",
                                        "Edges"},
@@ -212,11 +265,12 @@ int main(int argc, char* argv[]) {
             sf::Font gnuUnifont;
             gnuUnifont.loadFromFile("unifont-9.0.06.ttf");
             sf::Text infoText("", gnuUnifont, 12);
+            sf::Image image;
             sf::Texture texture;
             sf::RectangleShape texRect;
 
             if(argc == 3) {
-                if(!texture.loadFromFile(argv[2])) {
+                if(!image.loadFromFile(argv[2]) || !texture.loadFromImage(image)) {
                     std::cerr << "Error: " << argv[2] << " is not a valid texture file!" << std::endl;
                     return 0;
                 }
@@ -228,6 +282,7 @@ int main(int argc, char* argv[]) {
             sf::Vector2u winSize(window.getSize());
             window.setFramerateLimit(60);
             while(window.isOpen()) {
+                PB_TRACE_NAMED_ZONE(events, "editor events");
                 sf::Vector2i lastMousePos = mousePos;
                 mousePos = sf::Mouse::getPosition(window);
                 sf::Vector2i displacement = sf::Vector2i(mousePos.x - lastMousePos.x, mousePos.y - lastMousePos.y);
@@ -246,8 +301,8 @@ int main(int argc, char* argv[]) {
                     }
                     redraw = true;
                 }
-                sf::Vector2i lastSelectedTilePos = selectedTilePos;
-                selectedTilePos = sf::Vector2i(floor((mousePos.x + camPos.x) / zoom), floor((mousePos.y + camPos.y) / zoom));
+                pb::Vector2i lastSelectedTilePos = selectedTilePos;
+                selectedTilePos = pb::Vector2i(floor((mousePos.x + camPos.x) / zoom), floor((mousePos.y + camPos.y) / zoom));
                 if(lastSelectedTilePos != selectedTilePos)
                     redraw = true;
 
@@ -303,6 +358,14 @@ int main(int argc, char* argv[]) {
                         case sf::Keyboard::G:
                             showGrid = !showGrid;
                             break;
+                        case sf::Keyboard::B:
+                            if(argc == 3)
+                                autoGenerateAABBs(&image, resolution, &aabbVec, &pointVec, &edgeVec);
+                            break;
+                        case sf::Keyboard::P:
+                            if(argc == 3)
+                                autoGenerateContours(&image, resolution, &aabbVec, &pointVec, &edgeVec);
+                            break;
                         case sf::Keyboard::W:
                             texSize.y -= 1;
                             texRect.setSize(sf::Vector2f((texture.getSize().x + texSize.x) * zoom, (texture.getSize().y + texSize.y) * zoom));
@@ -348,9 +411,9 @@ int main(int argc, char* argv[]) {
                         case sf::Keyboard::Right:
                             ++id;
                             if(id >= aabbVec.size()) {
-                                aabbVec.push_back(std::vector < std::vector < sf::IntRect > >(47, std::vector < sf::IntRect >()));
-                                pointVec.push_back(std::vector < std::vector < sf::Vector2i > >(47, std::vector < sf::Vector2i >()));
-                                edgeVec.push_back(std::vector < std::vector < sf::IntRect > >(47, std::vector < sf::IntRect >()));
+                                aabbVec.push_back(std::vector < std::vector < pb::IntRect > >(47, std::vector < pb::IntRect >()));
+                                pointVec.push_back(std::vector < std::vector < pb::Vector2i > >(47, std::vector < pb::Vector2i >()));
+                                edgeVec.push_back(std::vector < std::vector < pb::IntRect > >(47, std::vector < pb::IntRect >()));
                             }
                             break;
                         }
@@ -370,7 +433,7 @@ int main(int argc, char* argv[]) {
                             case 0:
                                 if(selAABB) {
                                     selAABB = false;
-                                    sf::IntRect val(getAABBFromPoints(selectedTilePos, firstPos));
+                                    pb::IntRect val(getAABBFromPoints(selectedTilePos, firstPos));
                                     if(std::find(aabbVec[id][bitmask].begin(), aabbVec[id][bitmask].end(), val) == aabbVec[id][bitmask].end())
                                         aabbVec[id][bitmask].push_back(val);
                                 }
@@ -385,7 +448,7 @@ int main(int argc, char* argv[]) {
                                 break;
                             case 2:
                                 if(selEdge) {
-                                    sf::IntRect val(getEdgeFromPoints(snapEdge(selectedTilePos, firstPos), firstPos));
+                                    pb::IntRect val(getEdgeFromPoints(snapEdge(selectedTilePos, firstPos), firstPos));
                                     if((val.left == val.width) && (val.top == val.height))
                                         break;
                                     selEdge = false;
@@ -430,7 +493,7 @@ int main(int argc, char* argv[]) {
                                 break;
                             case 1:
                                 {
-                                std::vector < sf::Vector2i >::iterator foundit(std::find(pointVec[id][bitmask].begin(), pointVec[id][bitmask].end(), selectedTilePos));
+                                std::vector < pb::Vector2i >::iterator foundit(std::find(pointVec[id][bitmask].begin(), pointVec[id][bitmask].end(), selectedTilePos));
                                 if(foundit != pointVec[id][bitmask].end())
                                     pointVec[id][bitmask].erase(foundit);
                                 }
@@ -489,20 +552,17 @@ int main(int argc, char* argv[]) {
                         break;
                     }
                 }
+                PB_TRACE_END(events);
 
                 if(redraw) {
+                    PB_TRACE_NAMED_ZONE(phase, "editor rebuild");
                     redraw = false;
                     infoText.setString(help + "Mode: " + modeInfo[mode] + "\nSelected pixel: " + std::to_string(selectedTilePos.x) + ", " + std::to_string(selectedTilePos.y) + "\nBitmask: " + bitmaskInfo[bitmask] + " tile\nCurrent ID:" + std::to_string(id) + "\nCurrent texture size \"offset\":" + std::to_string(texSize.x) + "," + std::to_string(texSize.y) + "\nResolution:" + std::to_string(resolution.x) + "," + std::to_string(resolution.y));
                     infoText.setPosition(camPos);
 
-                    window.clear(colours[selColour]);
                     gridVA.clear();
                     pointyboxVA.clear();
 
-                    // Render bg texture
-                    if(renderTex)
-                        window.draw(texRect);
-
                     // Render grid
                     long long camXTL = floor(camPos.x / zoom),
                               camYTL = floor(camPos.y / zoom),
@@ -575,7 +635,7 @@ int main(int argc, char* argv[]) {
 
                     // Render aabb selection
                     if((mode == 0) && selAABB) {
-                        sf::IntRect val(getAABBFromPoints(selectedTilePos, firstPos));
+                        pb::IntRect val(getAABBFromPoints(selectedTilePos, firstPos));
                         pointyboxVA.append(sf::Vertex(sf::Vector2f(val.left * zoom, val.top * zoom), sf::Color(0, 255, 0, 127)));
                         pointyboxVA.append(sf::Vertex(sf::Vector2f((val.left + val.width) * zoom, val.top * zoom), sf::Color(0, 255, 0, 127)));
                         pointyboxVA.append(sf::Vertex(sf::Vector2f((val.left + val.width) * zoom, (val.top + val.height) * zoom), sf::Color(0, 255, 0, 127)));
@@ -584,7 +644,7 @@ int main(int argc, char* argv[]) {
                 
                     // Render edge selection
                     if((mode == 2) && selEdge) {
-                        sf::IntRect val(getEdgeFromPoints(snapEdge(selectedTilePos, firstPos), firstPos));
+                        pb::IntRect val(getEdgeFromPoints(snapEdge(selectedTilePos, firstPos), firstPos));
                         sf::Color thisColor(0, 255, 0, 127);
                         if((val.left == val.width) && (val.top == val.height))
                             thisColor = sf::Color(255, 0, 0, 127);
@@ -594,17 +654,23 @@ int main(int argc, char* argv[]) {
                         pointyboxVA.append(sf::Vertex(sf::Vector2f(val.left * zoom - thisEdgeThickness - 1, val.height * zoom + thisEdgeThickness), thisColor));
                     }
 
+                    PB_TRACE_NEXT(phase, "editor draw");
+                    window.clear(colours[selColour]);
+                    // Render bg texture
+                    if(renderTex)
+                        window.draw(texRect);
                     window.draw(gridVA);
                     window.draw(pointyboxVA);
                     window.draw(infoText);
 
+                    PB_TRACE_NEXT(phase, "editor present"); // Includes the frame limit sleep, so it's kept out of the draw zone
                     window.display();
                 }
             }
             ploader.save(&resolution, &aabbVec, &pointVec, &edgeVec);
         }
         else
-            std::cout << "BoxEdit pointybox editor\nUsage: " << argv[0] << " pb_file [guide_file]" << std::endl;
+            std::cout << "BoxEdit pointybox editor\nUsage: " << argv[0] << " pb_file [guide_file]\n       " << argv[0] << " --generate pb_file guide_file" << std::endl;
     } catch (const std::exception &exc) {
         std::cerr << "Exception:" << exc.what();
         return EXIT_FAILURE;
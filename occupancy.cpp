@@ -0,0 +1,118 @@
+#include "occupancy.hpp"
+#include <algorithm>
+#include <math.h>
+
+// Bits of word w which fall inside [x1, x2)
+static uint64_t wordMask(size_t w, unsigned int x1, unsigned int x2) {
+    unsigned int lo = std::max < size_t >(x1, w * 64) - w * 64,
+                 hi = std::min < size_t >(x2, w * 64 + 64) - w * 64;
+    uint64_t upTo = (hi >= 64) ? ~uint64_t(0) : ((uint64_t(1) << hi) - 1);
+    return upTo & ~((uint64_t(1) << lo) - 1);
+}
+
+// Converts a tile unit coordinate to a pixel boundary, clamped to the tile
+static unsigned int toPixel(float v, unsigned int res) {
+    long p = lround(v * float(res));
+    return (p < 0) ? 0 : ((p > long(res)) ? res : p);
+}
+
+const uint64_t* pb::OccupancyMap::build(size_t id, size_t bitmask) const {
+    uint64_t* bitmap = new uint64_t[wordsPerRow * resolution.y]();
+    Span < RangeRect > aabbs(dataset->getAABBs(id, bitmask));
+    for (size_t i = 0; i < aabbs.size(); ++i) {
+        unsigned int x1 = toPixel(aabbs[i].x1, resolution.x),
+                     x2 = toPixel(aabbs[i].x2, resolution.x),
+                     y1 = toPixel(aabbs[i].y1, resolution.y),
+                     y2 = toPixel(aabbs[i].y2, resolution.y);
+        if(x1 >= x2)
+            continue;
+        for (unsigned int y = y1; y < y2; ++y) {
+            for (size_t w = x1 / 64; w <= (x2 - 1) / 64; ++w)
+                bitmap[y * wordsPerRow + w] |= wordMask(w, x1, x2);
+        }
+    }
+    return bitmap;
+}
+
+const uint64_t* pb::OccupancyMap::getBitmap(size_t id, size_t bitmask) const {
+    if(id >= dataset->idCount())
+        return 0;
+    std::atomic < const uint64_t* >& slot = bitmaps[id * 47 + bitmask];
+    const uint64_t* bitmap = slot.load(std::memory_order_acquire);
+    if(bitmap)
+        return bitmap;
+    const uint64_t* built = build(id, bitmask);
+    if(slot.compare_exchange_strong(bitmap, built, std::memory_order_acq_rel))
+        return built;
+    delete[] built; // Another thread published first; bitmap now holds its result
+    return bitmap;
+}
+
+size_t pb::OccupancyMap::rowWords() const {
+    return wordsPerRow;
+}
+
+bool pb::OccupancyMap::solidAt(size_t id, size_t bitmask, float x, float y) const {
+    if((x < 0.0f) || (y < 0.0f))
+        return false;
+    return pixelSolid(id, bitmask, (unsigned int)(x * resolution.x), (unsigned int)(y * resolution.y));
+}
+
+bool pb::OccupancyMap::pixelSolid(size_t id, size_t bitmask, unsigned int x, unsigned int y) const {
+    if((x >= resolution.x) || (y >= resolution.y))
+        return false;
+    const uint64_t* bitmap = getBitmap(id, bitmask);
+    return bitmap && ((bitmap[y * wordsPerRow + x / 64] >> (x % 64)) & 1);
+}
+
+bool pb::OccupancyMap::spanSolid(size_t id, size_t bitmask, unsigned int row, unsigned int x1, unsigned int x2) const {
+    if(x1 >= x2)
+        return true;
+    if((row >= resolution.y) || (x2 > resolution.x))
+        return false;
+    const uint64_t* bitmap = getBitmap(id, bitmask);
+    if(!bitmap)
+        return false;
+    for (size_t w = x1 / 64; w <= (x2 - 1) / 64; ++w) {
+        uint64_t mask = wordMask(w, x1, x2);
+        if((bitmap[row * wordsPerRow + w] & mask) != mask)
+            return false;
+    }
+    return true;
+}
+
+bool pb::OccupancyMap::spanEmpty(size_t id, size_t bitmask, unsigned int row, unsigned int x1, unsigned int x2) const {
+    if(row >= resolution.y)
+        return true;
+    x2 = std::min(x2, resolution.x);
+    if(x1 >= x2)
+        return true;
+    const uint64_t* bitmap = getBitmap(id, bitmask);
+    if(!bitmap)
+        return true;
+    for (size_t w = x1 / 64; w <= (x2 - 1) / 64; ++w) {
+        if(bitmap[row * wordsPerRow + w] & wordMask(w, x1, x2))
+            return false;
+    }
+    return true;
+}
+
+bool pb::OccupancyMap::rowOccupied(size_t id, size_t bitmask, unsigned int row) const {
+    return !spanEmpty(id, bitmask, row, 0, resolution.x);
+}
+
+pb::OccupancyMap::OccupancyMap(std::shared_ptr < const Dataset > p_dataset) :
+    dataset(p_dataset),
+    resolution(p_dataset->getResolution()),
+    wordsPerRow((resolution.x + 63) / 64),
+    bitmaps(new std::atomic < const uint64_t* >[p_dataset->idCount() * 47])
+{
+    for (size_t slot = 0; slot < dataset->idCount() * 47; ++slot)
+        bitmaps[slot].store(0, std::memory_order_relaxed);
+}
+
+pb::OccupancyMap::~OccupancyMap() {
+    for (size_t slot = 0; slot < dataset->idCount() * 47; ++slot)
+        delete[] bitmaps[slot].load(std::memory_order_relaxed);
+    delete[] bitmaps;
+}
@@ -0,0 +1,40 @@
+#ifndef OCCUPANCY_INCLUDED
+#define OCCUPANCY_INCLUDED
+
+/*
+    Occupancy bitmaps for point-in-solid queries.
+    Each (id, bitmask) slot's AABBs are rasterized into a resolution.x * resolution.y bit grid, one bit per pixel, rows padded to whole 64-bit words (bit x of a row is bit x % 64 of word x / 64).
+    A pixel is solid if its area is covered by any AABB, so queries are half-open: a point exactly on an AABB's right or bottom side is outside it.
+    Bitmaps are built the first time their slot is queried and kept for as long as the OccupancyMap lives. Building is lock-free; if two threads race on a slot, one result is kept and the other discarded.
+*/
+
+#include <atomic>
+#include "pointybox.hpp"
+
+namespace pb {
+    class OccupancyMap {
+        std::shared_ptr < const Dataset > dataset;
+        Vector2u resolution;
+        size_t wordsPerRow;
+        std::atomic < const uint64_t* >* bitmaps; // One per slot, null until built
+
+        const uint64_t* build(size_t id, size_t bitmask) const;
+
+    public:
+        const uint64_t* getBitmap(size_t id, size_t bitmask) const;
+        size_t rowWords() const;
+
+        bool solidAt(size_t id, size_t bitmask, float x, float y) const;                        // (x, y) in tile units, like parsed data
+        bool pixelSolid(size_t id, size_t bitmask, unsigned int x, unsigned int y) const;
+        bool spanSolid(size_t id, size_t bitmask, unsigned int row, unsigned int x1, unsigned int x2) const; // Is every pixel in [x1, x2) of the row solid?
+        bool spanEmpty(size_t id, size_t bitmask, unsigned int row, unsigned int x1, unsigned int x2) const; // Is no pixel in [x1, x2) of the row solid?
+        bool rowOccupied(size_t id, size_t bitmask, unsigned int row) const;
+
+        OccupancyMap(std::shared_ptr < const Dataset > p_dataset);
+        OccupancyMap(const OccupancyMap&) = delete;
+        OccupancyMap& operator=(const OccupancyMap&) = delete;
+        ~OccupancyMap();
+    };
+}
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef PBTYPES_INCLUDED
+#define PBTYPES_INCLUDED
+
+/*
+    Dependency-free vector and rect types used by the pointybox core.
+    They are plain structs with the same members as their SFML counterparts (x, y / left, top, width, height), so code using them reads the same.
+    Include pointybox_sfml.hpp to convert to and from SFML types.
+*/
+
+namespace pb {
+    template < typename T >
+    struct Vector2 {
+        T x,
+          y;
+
+        Vector2() : x(0), y(0) { }
+        Vector2(T p_x, T p_y) : x(p_x), y(p_y) { }
+        template < typename U >
+        explicit Vector2(const Vector2 < U >& other) : x(T(other.x)), y(T(other.y)) { }
+    };
+
+    template < typename T >
+    bool operator==(const Vector2 < T >& a, const Vector2 < T >& b) { return (a.x == b.x) && (a.y == b.y); }
+    template < typename T >
+    bool operator!=(const Vector2 < T >& a, const Vector2 < T >& b) { return !(a == b); }
+
+    template < typename T >
+    struct Rect {
+        T left,
+          top,
+          width,
+          height;
+
+        Rect() : left(0), top(0), width(0), height(0) { }
+        Rect(T p_left, T p_top, T p_width, T p_height) : left(p_left), top(p_top), width(p_width), height(p_height) { }
+    };
+
+    template < typename T >
+    bool operator==(const Rect < T >& a, const Rect < T >& b) { return (a.left == b.left) && (a.top == b.top) && (a.width == b.width) && (a.height == b.height); }
+    template < typename T >
+    bool operator!=(const Rect < T >& a, const Rect < T >& b) { return !(a == b); }
+
+    typedef Vector2 < int > Vector2i;
+    typedef Vector2 < unsigned int > Vector2u;
+    typedef Vector2 < float > Vector2f;
+    typedef Rect < int > IntRect;
+}
+
+#endif
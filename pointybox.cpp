@@ -1,4 +1,8 @@
 #include "pointybox.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <exception>
+#include <new>
 //#include <iostream>
 
 pb::RangeRect::RangeRect(float p_x1, float p_y1, float p_x2, float p_y2) :
@@ -15,14 +19,30 @@ pb::AALine::AALine(bool p_x, float p_a, float p_s, float p_b) :
     b(p_b)
 { }
 
-bool pb::PointyboxLoader::load(sf::Vector2u* resolution, AABBVectorRaw* aabbVec, PointVectorRaw* pointVec, EdgeVectorRaw* edgeVec) {
+// Shared by the std::vector and arena backed loaders. New IDs are emplaced with 47 empty bitmasks, so nested arena vectors pick up the arena
+template < typename AABBVec, typename PointVec, typename EdgeVec >
+static bool loadVectors(const std::string& file, pb::Vector2u* resolution, AABBVec* aabbVec, PointVec* pointVec, EdgeVec* edgeVec, pb::LoadProgress* progress) {
+    PB_TRACE_ZONE("load");
+    PB_TRACE_NAMED_ZONE(read, "read file");
     std::ifstream fs(file, std::fstream::in | std::fstream::binary);
     if(!fs) {
         fs.close();
         return false;
     }
-    std::string str((std::istreambuf_iterator< char >(fs)), std::istreambuf_iterator< char >());
+    fs.seekg(0, std::fstream::end);
+    std::streamoff size = fs.tellg();
+    if(size < 0) // Can't seek
+        return false;
+    std::string str(size_t(size), '\0');
+    fs.seekg(0, std::fstream::beg);
+    if(progress) // Known before the read, so progress can be shown while it happens
+        progress->bytesTotal.store(str.size(), std::memory_order_relaxed);
+    if(!str.empty() && !fs.read(&str[0], str.size()))
+        return false;
     fs.close();
+    PB_TRACE_END(read);
+    PB_TRACE_ZONE("tokenize");
+    PB_TRACE_NAMED_ZONE(section, "resolution section");
     unsigned char resLoadState = 0, // 0 = X, 1 = Y, 2 = loaded
                   vec = 0; // 0 = aabb; 1 = point; 2 = edge
     std::string valBuf[4];
@@ -30,9 +50,9 @@ bool pb::PointyboxLoader::load(sf::Vector2u* resolution, AABBVectorRaw* aabbVec,
            bitmask = 0,
            n = 0,
            i = 0;
-    aabbVec->push_back(std::vector < std::vector < sf::IntRect > >(47, std::vector < sf::IntRect >())); // Fill vectors with initial spaces
-    pointVec->push_back(std::vector < std::vector < sf::Vector2i > >(47, std::vector < sf::Vector2i >()));
-    edgeVec->push_back(std::vector < std::vector < sf::IntRect > >(47, std::vector < sf::IntRect >()));
+    aabbVec->emplace_back(47); // Fill vectors with initial spaces
+    pointVec->emplace_back(47);
+    edgeVec->emplace_back(47);
     // Get resolution
     for (std::string resValBuf; i < str.size(); ++i) {
         if (str[i] == '\n') {
@@ -62,17 +82,24 @@ bool pb::PointyboxLoader::load(sf::Vector2u* resolution, AABBVectorRaw* aabbVec,
     }
     if(resLoadState != 2)
         return false;
+    PB_TRACE_NEXT(section, "AABB section");
     // Get everything else
     for (; i < str.size(); ++i) {
         if(vec > 2)
             return false;
+        if(progress && ((str[i] == '\n') || (str[i] == '#'))) { // An ID ends
+            progress->bytesDone.store(i + 1, std::memory_order_relaxed);
+            progress->idsDone.fetch_add(1, std::memory_order_relaxed);
+            if(progress->cancel.load(std::memory_order_relaxed))
+                return false;
+        }
         if (str[i] == '\n') {
             if(vec == 0)
-                aabbVec->push_back(std::vector < std::vector < sf::IntRect > >(47, std::vector < sf::IntRect >()));
+                aabbVec->emplace_back(47);
             else if(vec == 1)
-                pointVec->push_back(std::vector < std::vector < sf::Vector2i > >(47, std::vector < sf::Vector2i >()));
+                pointVec->emplace_back(47);
             else
-                edgeVec->push_back(std::vector < std::vector < sf::IntRect > >(47, std::vector < sf::IntRect >()));
+                edgeVec->emplace_back(47);
             ++id;
             bitmask = 0;
             n = 0;
@@ -99,12 +126,14 @@ bool pb::PointyboxLoader::load(sf::Vector2u* resolution, AABBVectorRaw* aabbVec,
                 }
 
                 if (valid) {
+                    if(bitmask >= 47) // More ; than bitmasks on this line
+                        return false;
                     if(vec == 0)
-                        aabbVec->at(id)[bitmask].push_back(sf::IntRect(std::stoi(valBuf[0]), std::stoi(valBuf[1]), std::stoi(valBuf[2]), std::stoi(valBuf[3])));
+                        aabbVec->at(id)[bitmask].push_back(pb::IntRect(std::stoi(valBuf[0]), std::stoi(valBuf[1]), std::stoi(valBuf[2]), std::stoi(valBuf[3])));
                     else if(vec == 1)
-                        pointVec->at(id)[bitmask].push_back(sf::Vector2i(std::stoi(valBuf[0]), std::stoi(valBuf[1])));
+                        pointVec->at(id)[bitmask].push_back(pb::Vector2i(std::stoi(valBuf[0]), std::stoi(valBuf[1])));
                     else
-                        edgeVec->at(id)[bitmask].push_back(sf::IntRect(std::stoi(valBuf[0]), std::stoi(valBuf[1]), std::stoi(valBuf[2]), std::stoi(valBuf[3])));
+                        edgeVec->at(id)[bitmask].push_back(pb::IntRect(std::stoi(valBuf[0]), std::stoi(valBuf[1]), std::stoi(valBuf[2]), std::stoi(valBuf[3])));
                 }
                 for (unsigned char it = 0; it < nMax; ++it)
                     valBuf[it] = "";
@@ -112,6 +141,7 @@ bool pb::PointyboxLoader::load(sf::Vector2u* resolution, AABBVectorRaw* aabbVec,
         }
         else if (str[i] == '#') {
             vec += 1;
+            PB_TRACE_NEXT(section, (vec == 1) ? "point section" : "edge section");
             id = 0;
             bitmask = 0;
             n = 0;
@@ -123,10 +153,23 @@ bool pb::PointyboxLoader::load(sf::Vector2u* resolution, AABBVectorRaw* aabbVec,
         else
             return false;
     }
+    if(progress) { // The last ID of the edge section has no terminator
+        progress->bytesDone.store(str.size(), std::memory_order_relaxed);
+        progress->idsDone.fetch_add(1, std::memory_order_relaxed);
+    }
     return true;
 }
 
-void pb::PointyboxLoader::save(sf::Vector2u* resolution, AABBVectorRaw* aabbVec, PointVectorRaw* pointVec, EdgeVectorRaw* edgeVec) {
+bool pb::PointyboxLoader::load(pb::Vector2u* resolution, AABBVectorRaw* aabbVec, PointVectorRaw* pointVec, EdgeVectorRaw* edgeVec, LoadProgress* progress) {
+    return loadVectors(file, resolution, aabbVec, pointVec, edgeVec, progress);
+}
+
+bool pb::PointyboxLoader::load(pb::Vector2u* resolution, ArenaAABBVectorRaw* aabbVec, ArenaPointVectorRaw* pointVec, ArenaEdgeVectorRaw* edgeVec) {
+    return loadVectors(file, resolution, aabbVec, pointVec, edgeVec, 0);
+}
+
+void pb::PointyboxLoader::save(pb::Vector2u* resolution, AABBVectorRaw* aabbVec, PointVectorRaw* pointVec, EdgeVectorRaw* edgeVec) {
+    PB_TRACE_ZONE("save");
     std::ofstream fs(file, std::fstream::out | std::fstream::binary);
     // Save resolution
     fs << std::to_string(resolution->x) << '\n' << std::to_string(resolution->y) << '\n';
@@ -172,89 +215,243 @@ void pb::PointyboxLoader::save(sf::Vector2u* resolution, AABBVectorRaw* aabbVec,
     fs.close();
 }
 
-bool pb::PointyboxLoader::parse(sf::Vector2u* resolution, AABBVector* aabbVec, PointVector* pointVec, EdgeVector* edgeVec) {
-    AABBVectorRaw aabbVecRaw;
-    PointVectorRaw pointVecRaw;
-    EdgeVectorRaw edgeVecRaw;
-    if(!load(resolution, &aabbVecRaw, &pointVecRaw, &edgeVecRaw))
+static pb::RangeRect convertAABB(const pb::IntRect& raw, pb::Vector2u* resolution) {
+    return pb::RangeRect(float(raw.left) / float(resolution->x),
+                         float(raw.top) / float(resolution->y),
+                         float(raw.left + raw.width) / float(resolution->x),
+                         float(raw.top + raw.height) / float(resolution->y));
+}
+
+static pb::Vector2f convertPoint(const pb::Vector2i& raw, pb::Vector2u* resolution) {
+    return pb::Vector2f((0.5f + float(raw.x)) / float(resolution->x),
+                        (0.5f + float(raw.y)) / float(resolution->y));
+}
+
+static bool convertEdge(const pb::IntRect& raw, pb::Vector2u* resolution, pb::AALine* edge) {
+    bool xAligned;
+    float alignedAxisVal,
+          min,
+          max;
+    if(raw.left == raw.width) {
+        xAligned = true;
+        alignedAxisVal = float(raw.left) / float(resolution->x);
+    }
+    else if(raw.top == raw.height) {
+        xAligned = false;
+        alignedAxisVal = float(raw.top) / float(resolution->y);
+    }
+    else // Two of the values on the same axis must be equal (must be axis aligned)
         return false;
-    //std::cout << "Started load. Resolution:" << resolution->x << ";" << resolution->y << std::endl;
-    
+
+    if(xAligned) {
+        if(raw.top == raw.height) // Edge mustn't be point
+            return false;
+        min = float(raw.top) / float(resolution->y);
+        max = float(raw.height) / float(resolution->y);
+    }
+    else {
+        if(raw.left == raw.width) // Edge mustn't be point
+            return false;
+        min = float(raw.left) / float(resolution->x);
+        max = float(raw.width) / float(resolution->x);
+    }
+
+    *edge = pb::AALine(xAligned, alignedAxisVal, min, max);
+    return true;
+}
+
+template < typename AABBVecRaw, typename PointVecRaw, typename EdgeVecRaw, typename AABBVec, typename PointVec, typename EdgeVec >
+static bool convertVectors(pb::Vector2u* resolution, const AABBVecRaw& aabbVecRaw, const PointVecRaw& pointVecRaw, const EdgeVecRaw& edgeVecRaw, AABBVec* aabbVec, PointVec* pointVec, EdgeVec* edgeVec) {
+    PB_TRACE_NAMED_ZONE(stage, "convert AABBs");
     for (size_t id = 0; id < aabbVecRaw.size(); ++id) {
-        aabbVec->push_back(std::vector < std::vector < RangeRect > >(47, std::vector < RangeRect >()));
+        aabbVec->emplace_back(47);
         for (size_t bitmask = 0; bitmask < 47; ++bitmask) {
             size_t itSize = aabbVecRaw.at(id)[bitmask].size();
-            for (size_t i = 0; i < itSize; ++i) {
-                aabbVec->at(id)[bitmask].push_back(RangeRect(
-                                                   float(aabbVecRaw.at(id)[bitmask][i].left) / float(resolution->x),
-                                                   float(aabbVecRaw.at(id)[bitmask][i].top) / float(resolution->y),
-                                                   float(aabbVecRaw.at(id)[bitmask][i].left + aabbVecRaw.at(id)[bitmask][i].width) / float(resolution->x),
-                                                   float(aabbVecRaw.at(id)[bitmask][i].top + aabbVecRaw.at(id)[bitmask][i].height) / float(resolution->y)));
-                //std::cout << "Load aabb [" << id << "][" << bitmask << "][" << (aabbVec->size() - 1) << "]=" << aabbVec->at(id)[bitmask][aabbVec->size() - 1].x1 << "," << aabbVec->at(id)[bitmask][aabbVec->size() - 1].y1 << "," << aabbVec->at(id)[bitmask][aabbVec->size() - 1].x2 << "," << aabbVec->at(id)[bitmask][aabbVec->size() - 1].y2 << std::endl;
-            }
+            aabbVec->back()[bitmask].reserve(itSize);
+            for (size_t i = 0; i < itSize; ++i)
+                aabbVec->back()[bitmask].push_back(convertAABB(aabbVecRaw.at(id)[bitmask][i], resolution));
         }
     }
     
+    PB_TRACE_NEXT(stage, "convert points");
     for (size_t id = 0; id < pointVecRaw.size(); ++id) {
-        pointVec->push_back(std::vector < std::vector < sf::Vector2f > >(47, std::vector < sf::Vector2f >()));
+        pointVec->emplace_back(47);
         for (size_t bitmask = 0; bitmask < 47; ++bitmask) {
             size_t itSize = pointVecRaw.at(id)[bitmask].size();
-            for (size_t i = 0; i < itSize; ++i) {
-                pointVec->at(id)[bitmask].push_back(sf::Vector2f(
-                                                    (0.5f + float(pointVecRaw.at(id)[bitmask][i].x)) / float(resolution->x),
-                                                    (0.5f + float(pointVecRaw.at(id)[bitmask][i].y)) / float(resolution->y)
-                                                    ));
-                //std::cout << "Load point [" << id << "][" << bitmask << "][" << (pointVec->size() - 1) << "]=" << pointVec->at(id)[bitmask][pointVec->size() - 1].x << "," << pointVec->at(id)[bitmask][pointVec->size() - 1].y << std::endl;
-            }
+            pointVec->back()[bitmask].reserve(itSize);
+            for (size_t i = 0; i < itSize; ++i)
+                pointVec->back()[bitmask].push_back(convertPoint(pointVecRaw.at(id)[bitmask][i], resolution));
         }
     }
     
+    PB_TRACE_NEXT(stage, "convert edges");
     for (size_t id = 0; id < edgeVecRaw.size(); ++id) {
-        edgeVec->push_back(std::vector < std::vector < AALine > >(47, std::vector < AALine >()));
+        edgeVec->emplace_back(47);
         for (size_t bitmask = 0; bitmask < 47; ++bitmask) {
             size_t itSize = edgeVecRaw.at(id)[bitmask].size();
+            edgeVec->back()[bitmask].reserve(itSize);
             for (size_t i = 0; i < itSize; ++i) {
-                bool xAligned;
-                float alignedAxisVal,
-                      min,
-                      max;
-                if(edgeVecRaw.at(id)[bitmask][i].left == edgeVecRaw.at(id)[bitmask][i].width) {
-                    xAligned = true;
-                    alignedAxisVal = float(edgeVecRaw.at(id)[bitmask][i].left) / float(resolution->x);
-                }
-                else if(edgeVecRaw.at(id)[bitmask][i].top == edgeVecRaw.at(id)[bitmask][i].height) {
-                    xAligned = false;
-                    alignedAxisVal = float(edgeVecRaw.at(id)[bitmask][i].top) / float(resolution->y);
-                }
-                else // Two of the values on the same axis must be equal (must be axis aligned)
+                pb::AALine edge(false, 0.0f, 0.0f, 0.0f);
+                if(!convertEdge(edgeVecRaw.at(id)[bitmask][i], resolution, &edge))
                     return false;
-                    
-                if(xAligned) {
-                    if(edgeVecRaw.at(id)[bitmask][i].top == edgeVecRaw.at(id)[bitmask][i].height) // Edge mustn't be point
-                        return false;
-                    min = float(edgeVecRaw.at(id)[bitmask][i].top) / float(resolution->y);
-                    max = float(edgeVecRaw.at(id)[bitmask][i].height) / float(resolution->y);
-                }
-                else {
-                    if(edgeVecRaw.at(id)[bitmask][i].left == edgeVecRaw.at(id)[bitmask][i].width) // Edge mustn't be point
-                        return false;
-                    min = float(edgeVecRaw.at(id)[bitmask][i].left) / float(resolution->x);
-                    max = float(edgeVecRaw.at(id)[bitmask][i].width) / float(resolution->x);
-                }
-                    
-                edgeVec->at(id)[bitmask].push_back(AALine(
-                                                   xAligned,
-                                                   alignedAxisVal,
-                                                   min,
-                                                   max
-                                                  ));
-                //std::cout << "Load edge [" << id << "][" << bitmask << "][" << (edgeVec->size() - 1) << "]=" << edgeVec->at(id)[bitmask][edgeVec->size() - 1].x << "," << edgeVec->at(id)[bitmask][edgeVec->size() - 1].a << "," << edgeVec->at(id)[bitmask][edgeVec->size() - 1].s << "," << edgeVec->at(id)[bitmask][edgeVec->size() - 1].b << std::endl;
+                edgeVec->back()[bitmask].push_back(edge);
             }
         }
     }
     return true;
 }
 
+bool pb::PointyboxLoader::parse(pb::Vector2u* resolution, AABBVector* aabbVec, PointVector* pointVec, EdgeVector* edgeVec, LoadProgress* progress) {
+    PB_TRACE_ZONE("parse");
+    AABBVectorRaw aabbVecRaw;
+    PointVectorRaw pointVecRaw;
+    EdgeVectorRaw edgeVecRaw;
+    if(!load(resolution, &aabbVecRaw, &pointVecRaw, &edgeVecRaw, progress))
+        return false;
+    if(progress && progress->cancel.load(std::memory_order_relaxed))
+        return false;
+    //std::cout << "Started load. Resolution:" << resolution->x << ";" << resolution->y << std::endl;
+    return convertVectors(resolution, aabbVecRaw, pointVecRaw, edgeVecRaw, aabbVec, pointVec, edgeVec);
+}
+
+bool pb::PointyboxLoader::parse(pb::Vector2u* resolution, ArenaAABBVector* aabbVec, ArenaPointVector* pointVec, ArenaEdgeVector* edgeVec) {
+    PB_TRACE_ZONE("parse");
+    Arena rawArena;
+    ArenaAABBVectorRaw aabbVecRaw(&rawArena);
+    ArenaPointVectorRaw pointVecRaw(&rawArena);
+    ArenaEdgeVectorRaw edgeVecRaw(&rawArena);
+    if(!load(resolution, &aabbVecRaw, &pointVecRaw, &edgeVecRaw))
+        return false;
+    return convertVectors(resolution, aabbVecRaw, pointVecRaw, edgeVecRaw, aabbVec, pointVec, edgeVec);
+}
+
+std::shared_ptr < const pb::Dataset > pb::PointyboxLoader::parse() {
+    PB_TRACE_ZONE("parse");
+    pb::Vector2u resolution;
+    AABBVectorRaw aabbVecRaw;
+    PointVectorRaw pointVecRaw;
+    EdgeVectorRaw edgeVecRaw;
+    try {
+        if(!load(&resolution, &aabbVecRaw, &pointVecRaw, &edgeVecRaw))
+            return std::shared_ptr < const Dataset >();
+    }
+    catch (const std::exception&) { // Empty or out of range numbers make std::stoi throw
+        return std::shared_ptr < const Dataset >();
+    }
+
+    // Size everything up front so the dataset is a single allocation
+    PB_TRACE_NAMED_ZONE(stage, "size dataset");
+    size_t ids = std::max(aabbVecRaw.size(), std::max(pointVecRaw.size(), edgeVecRaw.size())),
+           aabbCount = 0,
+           pointCount = 0,
+           edgeCount = 0;
+    for (size_t id = 0; id < ids; ++id) {
+        for (size_t bitmask = 0; bitmask < 47; ++bitmask) {
+            if(id < aabbVecRaw.size())
+                aabbCount += aabbVecRaw[id][bitmask].size();
+            if(id < pointVecRaw.size())
+                pointCount += pointVecRaw[id][bitmask].size();
+            if(id < edgeVecRaw.size())
+                edgeCount += edgeVecRaw[id][bitmask].size();
+        }
+    }
+
+    PB_TRACE_NEXT(stage, "convert into dataset");
+    std::shared_ptr < Dataset > dataset(new Dataset(resolution, ids, aabbCount, pointCount, edgeCount));
+    size_t aabbN = 0,
+           pointN = 0,
+           edgeN = 0;
+    for (size_t id = 0; id < ids; ++id) {
+        for (size_t bitmask = 0; bitmask < 47; ++bitmask) {
+            size_t slot = id * 47 + bitmask;
+            dataset->aabbStart[slot] = aabbN;
+            dataset->pointStart[slot] = pointN;
+            dataset->edgeStart[slot] = edgeN;
+            if(id < aabbVecRaw.size()) {
+                for (size_t i = 0; i < aabbVecRaw[id][bitmask].size(); ++i)
+                    new (&dataset->aabbs[aabbN++]) RangeRect(convertAABB(aabbVecRaw[id][bitmask][i], &resolution));
+            }
+            if(id < pointVecRaw.size()) {
+                for (size_t i = 0; i < pointVecRaw[id][bitmask].size(); ++i)
+                    new (&dataset->points[pointN++]) pb::Vector2f(convertPoint(pointVecRaw[id][bitmask][i], &resolution));
+            }
+            if(id < edgeVecRaw.size()) {
+                for (size_t i = 0; i < edgeVecRaw[id][bitmask].size(); ++i) {
+                    AALine* edge = new (&dataset->edges[edgeN++]) AALine(false, 0.0f, 0.0f, 0.0f);
+                    if(!convertEdge(edgeVecRaw[id][bitmask][i], &resolution, edge))
+                        return std::shared_ptr < const Dataset >();
+                }
+            }
+        }
+    }
+    dataset->aabbStart[ids * 47] = aabbN;
+    dataset->pointStart[ids * 47] = pointN;
+    dataset->edgeStart[ids * 47] = edgeN;
+    return dataset;
+}
+
+// Rounds an offset up to the alignment of T
+template < typename T >
+static size_t alignFor(size_t offset) {
+    return (offset + alignof(T) - 1) / alignof(T) * alignof(T);
+}
+
+pb::Dataset::Dataset(pb::Vector2u p_resolution, size_t p_ids, size_t aabbCount, size_t pointCount, size_t edgeCount) :
+    resolution(p_resolution),
+    ids(p_ids)
+{
+    size_t slots = ids * 47 + 1,
+           aabbOffset = alignFor < RangeRect >(slots * 3 * sizeof(uint32_t)),
+           pointOffset = alignFor < pb::Vector2f >(aabbOffset + aabbCount * sizeof(RangeRect)),
+           edgeOffset = alignFor < AALine >(pointOffset + pointCount * sizeof(pb::Vector2f));
+    blockSize = edgeOffset + edgeCount * sizeof(AALine);
+    block = static_cast < char* >(::operator new(blockSize));
+    aabbStart = reinterpret_cast < uint32_t* >(block);
+    pointStart = aabbStart + slots;
+    edgeStart = pointStart + slots;
+    aabbs = reinterpret_cast < RangeRect* >(block + aabbOffset);
+    points = reinterpret_cast < pb::Vector2f* >(block + pointOffset);
+    edges = reinterpret_cast < AALine* >(block + edgeOffset);
+}
+
+pb::Dataset::~Dataset() {
+    ::operator delete(block); // Contents are trivially destructible
+}
+
+pb::Vector2u pb::Dataset::getResolution() const {
+    return resolution;
+}
+
+size_t pb::Dataset::idCount() const {
+    return ids;
+}
+
+pb::Span < pb::RangeRect > pb::Dataset::getAABBs(size_t id, size_t bitmask) const {
+    size_t slot = id * 47 + bitmask;
+    return Span < RangeRect >(aabbs + aabbStart[slot], aabbs + aabbStart[slot + 1]);
+}
+
+pb::Span < pb::Vector2f > pb::Dataset::getPoints(size_t id, size_t bitmask) const {
+    size_t slot = id * 47 + bitmask;
+    return Span < pb::Vector2f >(points + pointStart[slot], points + pointStart[slot + 1]);
+}
+
+pb::Span < pb::AALine > pb::Dataset::getEdges(size_t id, size_t bitmask) const {
+    size_t slot = id * 47 + bitmask;
+    return Span < AALine >(edges + edgeStart[slot], edges + edgeStart[slot + 1]);
+}
+
+size_t pb::Dataset::memoryUsage() const {
+    return sizeof(*this) + blockSize;
+}
+
+pb::LoadProgress::LoadProgress() :
+    bytesDone(0),
+    bytesTotal(0),
+    idsDone(0),
+    cancel(false)
+{ }
+
 pb::PointyboxLoader::PointyboxLoader(std::string path):
     file(path)
 { }
@@ -8,14 +8,18 @@
         # (indicates the end of the current vector/start of next vector)
         \n (indicates the end of the first vector level [tile ID], moves to its next index)
         ; (indicates the end of the second vector level [bitmask], moves to its next index)
-        , (indicates the end of the current data [x, y, w or h value for a sf::Vector2i or a sf::IntRect], so x moves to y (i.e.) and when pairs or quads are complete, they get recorded.)
+        , (indicates the end of the current data [x, y, w or h value for a pb::Vector2i or a pb::IntRect], so x moves to y (i.e.) and when pairs or quads are complete, they get recorded.)
     If invalid characters are found (not in above list, numbers or empty spaces), load returns false
 */
 
+#include <atomic>
 #include <fstream>
+#include <memory>
+#include <stdint.h>
 #include <string.h>
 #include <vector>
-#include <SFML/Graphics.hpp>
+#include "pbtypes.hpp"
+#include "arena.hpp"
 
 namespace pb {
     // Misc
@@ -39,21 +43,91 @@ namespace pb {
 
     // Main containers (special type based)
     typedef std::vector < std::vector < std::vector < RangeRect > > > AABBVector;
-    typedef std::vector < std::vector < std::vector < sf::Vector2f > > > PointVector;
+    typedef std::vector < std::vector < std::vector < Vector2f > > > PointVector;
     typedef std::vector < std::vector < std::vector < AALine > > > EdgeVector;
 
     // Raw versions (int based)
-    typedef std::vector < std::vector < std::vector < sf::IntRect > > > AABBVectorRaw;
-    typedef std::vector < std::vector < std::vector < sf::Vector2i > > > PointVectorRaw;
-    typedef std::vector < std::vector < std::vector < sf::IntRect > > > EdgeVectorRaw;
+    typedef std::vector < std::vector < std::vector < IntRect > > > AABBVectorRaw;
+    typedef std::vector < std::vector < std::vector < Vector2i > > > PointVectorRaw;
+    typedef std::vector < std::vector < std::vector < IntRect > > > EdgeVectorRaw;
+
+    // Arena backed versions. Construct them with the arena, e.g. ArenaAABBVector aabbVec(&arena);
+    typedef ArenaVector < ArenaVector < ArenaVector < RangeRect > > > ArenaAABBVector;
+    typedef ArenaVector < ArenaVector < ArenaVector < Vector2f > > > ArenaPointVector;
+    typedef ArenaVector < ArenaVector < ArenaVector < AALine > > > ArenaEdgeVector;
+    typedef ArenaVector < ArenaVector < ArenaVector < IntRect > > > ArenaAABBVectorRaw;
+    typedef ArenaVector < ArenaVector < ArenaVector < Vector2i > > > ArenaPointVectorRaw;
+    typedef ArenaVector < ArenaVector < ArenaVector < IntRect > > > ArenaEdgeVectorRaw;
+
+    // Read-only view of a contiguous array
+    template < typename T >
+    class Span {
+        const T* first;
+        const T* last;
+
+    public:
+        const T* begin() const { return first; }
+        const T* end() const { return last; }
+        size_t size() const { return last - first; }
+        bool empty() const { return first == last; }
+        const T& operator[](size_t i) const { return first[i]; }
+        Span(const T* p_first, const T* p_last) : first(p_first), last(p_last) { }
+    };
+
+    /*
+        Immutable parsed pointybox data, as returned by PointyboxLoader::parse().
+        Everything lives in a single allocation: a table of per-slot offsets followed by flat arrays of RangeRects, points and AALines.
+        It is never modified after parse() builds it, so any number of threads can read it at once. Share it through the returned shared_ptr instead of copying it.
+        IDs missing from one of the file's sections are empty slots.
+    */
+    class Dataset {
+        Vector2u resolution;
+        size_t ids,
+               blockSize;
+        char* block;
+        uint32_t* aabbStart;    // Slot s = id * 47 + bitmask owns [start[s], start[s + 1])
+        uint32_t* pointStart;
+        uint32_t* edgeStart;
+        RangeRect* aabbs;
+        Vector2f* points;
+        AALine* edges;
+
+        Dataset(Vector2u p_resolution, size_t p_ids, size_t aabbCount, size_t pointCount, size_t edgeCount);
+        friend class PointyboxLoader;
+
+    public:
+        Vector2u getResolution() const;
+        size_t idCount() const;
+        Span < RangeRect > getAABBs(size_t id, size_t bitmask) const;
+        Span < Vector2f > getPoints(size_t id, size_t bitmask) const;
+        Span < AALine > getEdges(size_t id, size_t bitmask) const;
+        size_t memoryUsage() const;
+
+        Dataset(const Dataset&) = delete;
+        Dataset& operator=(const Dataset&) = delete;
+        ~Dataset();
+    };
+
+    // Progress reporting and cancellation for load/parse. Other threads may read it and set cancel while loading
+    struct LoadProgress {
+        std::atomic < size_t > bytesDone,
+                               bytesTotal,  // File size, set once the file is opened and before it is read
+                               idsDone;     // Tile IDs read so far, summed over the 3 sections
+        std::atomic < bool > cancel;        // Checked once per tile ID; load/parse then return false
+
+        LoadProgress();
+    };
 
     class PointyboxLoader {
         std::string file;
 
     public:
-        bool load(sf::Vector2u* resolution, AABBVectorRaw* aabbVec, PointVectorRaw* pointVec, EdgeVectorRaw* edgeVec);
-        void save(sf::Vector2u* resolution, AABBVectorRaw* aabbVec, PointVectorRaw* pointVec, EdgeVectorRaw* edgeVec); 
-        bool parse(sf::Vector2u* resolution, AABBVector* aabbVec, PointVector* pointVec, EdgeVector* edgeVec);
+        bool load(Vector2u* resolution, AABBVectorRaw* aabbVec, PointVectorRaw* pointVec, EdgeVectorRaw* edgeVec, LoadProgress* progress = 0);
+        void save(Vector2u* resolution, AABBVectorRaw* aabbVec, PointVectorRaw* pointVec, EdgeVectorRaw* edgeVec); 
+        bool parse(Vector2u* resolution, AABBVector* aabbVec, PointVector* pointVec, EdgeVector* edgeVec, LoadProgress* progress = 0);
+        bool load(Vector2u* resolution, ArenaAABBVectorRaw* aabbVec, ArenaPointVectorRaw* pointVec, ArenaEdgeVectorRaw* edgeVec);
+        bool parse(Vector2u* resolution, ArenaAABBVector* aabbVec, ArenaPointVector* pointVec, ArenaEdgeVector* edgeVec); // Raw data goes in a temporary arena of its own
+        std::shared_ptr < const Dataset > parse(); // Returns an empty pointer on failure, including invalid numbers. Never throws for bad input
         PointyboxLoader(std::string path);
     };
 }
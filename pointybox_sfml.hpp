@@ -0,0 +1,34 @@
+#ifndef POINTYBOX_SFML_INCLUDED
+#define POINTYBOX_SFML_INCLUDED
+
+/*
+    Optional SFML adapter for the pointybox core.
+    Converts between the core's vector and rect types and SFML's. Only code which already depends on SFML should include this.
+*/
+
+#include <SFML/Graphics.hpp>
+#include "pbtypes.hpp"
+
+namespace pb {
+    template < typename T >
+    inline sf::Vector2 < T > toSFML(const Vector2 < T >& v) {
+        return sf::Vector2 < T >(v.x, v.y);
+    }
+
+    template < typename T >
+    inline Vector2 < T > fromSFML(const sf::Vector2 < T >& v) {
+        return Vector2 < T >(v.x, v.y);
+    }
+
+    template < typename T >
+    inline sf::Rect < T > toSFML(const Rect < T >& r) {
+        return sf::Rect < T >(r.left, r.top, r.width, r.height);
+    }
+
+    template < typename T >
+    inline Rect < T > fromSFML(const sf::Rect < T >& r) {
+        return Rect < T >(r.left, r.top, r.width, r.height);
+    }
+}
+
+#endif
@@ -0,0 +1,83 @@
+#include "pool.hpp"
+#include <algorithm>
+
+void pb::WorkerPool::runJobs(unsigned int worker) {
+    for (size_t i = next++; i < jobs; i = next++)
+        (*job)(i, worker);
+}
+
+void pb::WorkerPool::work(unsigned int worker) {
+    uint64_t seen = 0;
+    std::unique_lock < std::mutex > lock(mutex);
+    while(true) {
+        wake.wait(lock, [&]() { return stopping || (batch != seen); });
+        if(stopping)
+            return;
+        seen = batch;
+        lock.unlock();
+        runJobs(worker);
+        lock.lock();
+        if(--busy == 0)
+            finished.notify_one();
+    }
+}
+
+void pb::WorkerPool::run(size_t p_jobs, const Job& p_job) {
+    if(p_jobs == 0)
+        return;
+    std::lock_guard < std::mutex > serial(runMutex);
+    if(helpers.empty() || (p_jobs == 1)) { // Not worth waking anyone
+        for (size_t i = 0; i < p_jobs; ++i)
+            p_job(i, 0);
+        return;
+    }
+    {
+        std::lock_guard < std::mutex > lock(mutex);
+        job = &p_job;
+        jobs = p_jobs;
+        next = 0;
+        busy = helpers.size();
+        ++batch;
+    }
+    wake.notify_all();
+    runJobs(0);
+    std::unique_lock < std::mutex > lock(mutex);
+    finished.wait(lock, [this]() { return busy == 0; });
+}
+
+unsigned int pb::WorkerPool::size() const {
+    return helpers.size() + 1;
+}
+
+unsigned int pb::WorkerPool::defaultThreads() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+pb::WorkerPool& pb::WorkerPool::shared() {
+    static WorkerPool pool;
+    return pool;
+}
+
+pb::WorkerPool::WorkerPool(unsigned int threads) :
+    job(0),
+    jobs(0),
+    next(0),
+    batch(0),
+    busy(0),
+    stopping(false)
+{
+    if(threads == 0)
+        threads = defaultThreads();
+    for (unsigned int i = 1; i < threads; ++i)
+        helpers.push_back(std::thread(&WorkerPool::work, this, i));
+}
+
+pb::WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard < std::mutex > lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (size_t i = 0; i < helpers.size(); ++i)
+        helpers[i].join();
+}
@@ -0,0 +1,55 @@
+#ifndef POOL_INCLUDED
+#define POOL_INCLUDED
+
+/*
+    A persistent pool of worker threads for data parallel loops.
+    run() hands out job indices [0, jobs) to the pool's threads and the calling thread, and returns once every job is done.
+    The threads are started once and sleep between calls, so it is cheap enough to call every frame. Use WorkerPool::shared() unless a specific thread count is needed.
+    Calls to run() on the same pool are serialised, so a job must never call run() on its own pool.
+*/
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+namespace pb {
+    class WorkerPool {
+    public:
+        // worker is in [0, size()) and unique among the threads running at once, e.g. to index per-thread scratch buffers. The calling thread is worker 0
+        typedef std::function < void(size_t job, unsigned int worker) > Job;
+
+    private:
+        std::vector < std::thread > helpers;
+        std::mutex mutex,
+                   runMutex;                // Held for the whole of run()
+        std::condition_variable wake,
+                                finished;
+        const Job* job;
+        size_t jobs;
+        std::atomic < size_t > next;
+        uint64_t batch;                     // Bumped by run() to wake the helpers
+        unsigned int busy;                  // Helpers still working on the current batch
+        bool stopping;
+
+        void runJobs(unsigned int worker);
+        void work(unsigned int worker);
+
+    public:
+        void run(size_t p_jobs, const Job& p_job);
+        unsigned int size() const;
+
+        static unsigned int defaultThreads();   // Hardware concurrency, at least 1
+        static WorkerPool& shared();            // Process wide pool of defaultThreads() threads, started on first use
+
+        WorkerPool(unsigned int threads = 0);   // Including the calling thread. 0 uses defaultThreads()
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+        ~WorkerPool();
+    };
+}
+
+#endif
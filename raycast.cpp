@@ -0,0 +1,159 @@
+#include "raycast.hpp"
+#include <algorithm>
+#include <limits>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+static const int32_t noEdge = std::numeric_limits < int32_t >::max(); // Loses every tie, so the first nearer hit always replaces it
+
+// Is a hit at distance t with edge index i nearer than the current best? Ties go to the edge added first
+static bool nearer(float t, int32_t i, float best, int32_t bestIndex) {
+    return (t < best) || ((t == best) && (i < bestIndex));
+}
+
+void pb::EdgeSet::add(const AALine& edge, float offsetX, float offsetY) {
+    int32_t index = edges.size();
+    if(edge.x) {
+        xA.push_back(edge.a + offsetX);
+        xS.push_back(edge.s + offsetY);
+        xB.push_back(edge.b + offsetY);
+        xIndex.push_back(index);
+        edges.push_back(AALine(true, edge.a + offsetX, edge.s + offsetY, edge.b + offsetY));
+    }
+    else {
+        yA.push_back(edge.a + offsetY);
+        yS.push_back(edge.s + offsetX);
+        yB.push_back(edge.b + offsetX);
+        yIndex.push_back(index);
+        edges.push_back(AALine(false, edge.a + offsetY, edge.s + offsetX, edge.b + offsetX));
+    }
+}
+
+void pb::EdgeSet::add(Span < AALine > tileEdges, float offsetX, float offsetY) {
+    for (size_t i = 0; i < tileEdges.size(); ++i)
+        add(tileEdges[i], offsetX, offsetY);
+}
+
+void pb::EdgeSet::clear() {
+    xA.clear(); xS.clear(); xB.clear(); xIndex.clear();
+    yA.clear(); yS.clear(); yB.clear(); yIndex.clear();
+    edges.clear();
+}
+
+size_t pb::EdgeSet::size() const {
+    return edges.size();
+}
+
+void pb::EdgeSet::castOne(const Ray& ray, RayHit* hit) const {
+    float invDX = 1.0f / ray.dx,
+          invDY = 1.0f / ray.dy,
+          best = ray.maxDistance;
+    int32_t bestIndex = noEdge;
+    for (size_t i = 0; i < xA.size(); ++i) {
+        float t = (xA[i] - ray.ox) * invDX,
+              c = ray.oy + t * ray.dy;
+        if((t >= 0.0f) && (c >= xS[i]) && (c <= xB[i]) && nearer(t, xIndex[i], best, bestIndex)) {
+            best = t;
+            bestIndex = xIndex[i];
+        }
+    }
+    for (size_t i = 0; i < yA.size(); ++i) {
+        float t = (yA[i] - ray.oy) * invDY,
+              c = ray.ox + t * ray.dx;
+        if((t >= 0.0f) && (c >= yS[i]) && (c <= yB[i]) && nearer(t, yIndex[i], best, bestIndex)) {
+            best = t;
+            bestIndex = yIndex[i];
+        }
+    }
+    hit->distance = best;
+    hit->edge = (bestIndex == noEdge) ? -1 : bestIndex;
+}
+
+#ifdef __SSE2__
+// Tests the 4 rays of a packet against one line of each orientation's arrays
+static inline void castPacketLines(const float* lineA, const float* lineS, const float* lineB, const int32_t* lineIndex, size_t count,
+                                   __m128 fixedO, __m128 freeO, __m128 invFixedD, __m128 freeD, __m128& best, __m128i& bestIndex) {
+    const __m128 zero = _mm_setzero_ps();
+    for (size_t i = 0; i < count; ++i) {
+        __m128 t = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(lineA[i]), fixedO), invFixedD),
+               c = _mm_add_ps(freeO, _mm_mul_ps(t, freeD));
+        __m128i index = _mm_set1_epi32(lineIndex[i]);
+        __m128 closer = _mm_or_ps(_mm_cmplt_ps(t, best),
+                                  _mm_and_ps(_mm_cmpeq_ps(t, best), _mm_castsi128_ps(_mm_cmplt_epi32(index, bestIndex))));
+        __m128 hit = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(t, zero), closer),
+                                _mm_and_ps(_mm_cmpge_ps(c, _mm_set1_ps(lineS[i])), _mm_cmple_ps(c, _mm_set1_ps(lineB[i]))));
+        best = _mm_or_ps(_mm_and_ps(hit, t), _mm_andnot_ps(hit, best));
+        __m128i hitI = _mm_castps_si128(hit);
+        bestIndex = _mm_or_si128(_mm_and_si128(hitI, index), _mm_andnot_si128(hitI, bestIndex));
+    }
+}
+#endif
+
+void pb::EdgeSet::castPacket(const Ray* rays, RayHit* hits) const {
+#ifdef __SSE2__
+    const __m128 one = _mm_set1_ps(1.0f);
+    __m128 ox = _mm_setr_ps(rays[0].ox, rays[1].ox, rays[2].ox, rays[3].ox),
+           oy = _mm_setr_ps(rays[0].oy, rays[1].oy, rays[2].oy, rays[3].oy),
+           dx = _mm_setr_ps(rays[0].dx, rays[1].dx, rays[2].dx, rays[3].dx),
+           dy = _mm_setr_ps(rays[0].dy, rays[1].dy, rays[2].dy, rays[3].dy),
+           best = _mm_setr_ps(rays[0].maxDistance, rays[1].maxDistance, rays[2].maxDistance, rays[3].maxDistance);
+    __m128i bestIndex = _mm_set1_epi32(noEdge);
+    castPacketLines(xA.data(), xS.data(), xB.data(), xIndex.data(), xA.size(), ox, oy, _mm_div_ps(one, dx), dy, best, bestIndex);
+    castPacketLines(yA.data(), yS.data(), yB.data(), yIndex.data(), yA.size(), oy, ox, _mm_div_ps(one, dy), dx, best, bestIndex);
+
+    float distances[4];
+    int32_t indices[4];
+    _mm_storeu_ps(distances, best);
+    _mm_storeu_si128(reinterpret_cast < __m128i* >(indices), bestIndex);
+    for (unsigned char i = 0; i < 4; ++i) {
+        hits[i].distance = distances[i];
+        hits[i].edge = (indices[i] == noEdge) ? -1 : indices[i];
+    }
+#else
+    for (unsigned char i = 0; i < 4; ++i)
+        castOne(rays[i], &hits[i]);
+#endif
+}
+
+void pb::EdgeSet::cast(const Ray* rays, RayHit* hits, size_t count) const {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+        castPacket(rays + i, hits + i);
+    for (; i < count; ++i)
+        castOne(rays[i], &hits[i]);
+}
+
+void pb::EdgeSet::castParallel(const Ray* rays, RayHit* hits, size_t count, WorkerPool* pool) const {
+    const size_t chunk = 256; // Rays per job; a multiple of the packet size
+    (pool ? *pool : WorkerPool::shared()).run((count + chunk - 1) / chunk, [&](size_t job, unsigned int) {
+        size_t first = job * chunk;
+        cast(rays + first, hits + first, std::min(chunk, count - first));
+    });
+}
+
+void pb::EdgeSet::castReference(const Ray* rays, RayHit* hits, size_t count) const {
+    for (size_t r = 0; r < count; ++r) {
+        const Ray& ray = rays[r];
+        float best = ray.maxDistance;
+        int32_t bestIndex = noEdge;
+        for (size_t i = 0; i < edges.size(); ++i) {
+            const AALine& edge = edges[i];
+            float t, c;
+            if(edge.x) {
+                t = (edge.a - ray.ox) * (1.0f / ray.dx);
+                c = ray.oy + t * ray.dy;
+            }
+            else {
+                t = (edge.a - ray.oy) * (1.0f / ray.dy);
+                c = ray.ox + t * ray.dx;
+            }
+            if((t >= 0.0f) && (c >= edge.s) && (c <= edge.b) && nearer(t, i, best, bestIndex)) {
+                best = t;
+                bestIndex = i;
+            }
+        }
+        hits[r].distance = best;
+        hits[r].edge = (bestIndex == noEdge) ? -1 : bestIndex;
+    }
+}
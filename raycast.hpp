@@ -0,0 +1,52 @@
+#ifndef RAYCAST_INCLUDED
+#define RAYCAST_INCLUDED
+
+/*
+    Batched raycasting against AALines.
+    An EdgeSet keeps X aligned (|) and Y aligned (-) lines in separate structures of arrays, so a packet of 4 rays can be tested against one line at a time with SSE.
+    Edges are usually added per tile, offset to the tile's position, so everything is in the same space as the rays.
+    A ray hits a line if it crosses it at a distance in [0, maxDistance]. Distances are in multiples of the ray direction, so they are real distances for unit directions.
+    The nearest hit wins; if two hits are equally near, the edge added first wins. cast, castParallel and castReference all give the same results.
+*/
+
+#include "pointybox.hpp"
+#include "pool.hpp"
+
+namespace pb {
+    struct Ray {
+        float ox,           // Origin
+              oy,
+              dx,           // Direction
+              dy,
+              maxDistance;
+    };
+
+    struct RayHit {
+        float distance;
+        int32_t edge;       // Index of the hit edge in insertion order, or -1 if nothing was hit
+    };
+
+    class EdgeSet {
+        // X aligned lines: x = a, s <= y <= b. Y aligned lines: y = a, s <= x <= b
+        std::vector < float > xA, xS, xB,
+                              yA, yS, yB;
+        std::vector < int32_t > xIndex,
+                                yIndex;
+        std::vector < AALine > edges;   // All edges in insertion order, for castReference
+
+        void castPacket(const Ray* rays, RayHit* hits) const;
+        void castOne(const Ray& ray, RayHit* hit) const;
+
+    public:
+        void add(const AALine& edge, float offsetX = 0.0f, float offsetY = 0.0f);
+        void add(Span < AALine > tileEdges, float offsetX = 0.0f, float offsetY = 0.0f);
+        void clear();
+        size_t size() const;
+
+        void cast(const Ray* rays, RayHit* hits, size_t count) const;
+        void castParallel(const Ray* rays, RayHit* hits, size_t count, WorkerPool* pool = 0) const; // 0 uses WorkerPool::shared()
+        void castReference(const Ray* rays, RayHit* hits, size_t count) const;    // Brute force, one ray and one edge at a time
+    };
+}
+
+#endif
@@ -0,0 +1,135 @@
+#include "trace.hpp"
+
+#ifdef PB_TRACE
+
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace {
+    struct Event {
+        const char* name;
+        int64_t start,      // Nanoseconds, steady clock
+                duration;
+    };
+
+    const size_t chunkEvents = 4096;
+
+    // Only the owning thread writes. count is published with release, so dump() can read a chunk while it's still being filled
+    struct Chunk {
+        Event events[chunkEvents];
+        std::atomic < size_t > count;
+        std::atomic < Chunk* > next;
+
+        Chunk() : count(0), next(0) { }
+    };
+
+    // One per recording thread, pushed onto a lock-free list. Never freed, so events from finished threads still get dumped
+    struct ThreadBuffer {
+        uint32_t tid;
+        Chunk* first;
+        Chunk* last;
+        ThreadBuffer* next;
+    };
+
+    std::atomic < ThreadBuffer* > buffers(0);
+    std::atomic < uint32_t > nextTid(1);
+    thread_local ThreadBuffer* localBuffer = 0;
+
+    int64_t now() {
+        return std::chrono::duration_cast < std::chrono::nanoseconds >(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    ThreadBuffer* threadBuffer() {
+        if(!localBuffer) {
+            ThreadBuffer* buffer = new ThreadBuffer;
+            buffer->tid = nextTid++;
+            buffer->first = buffer->last = new Chunk;
+            buffer->next = buffers.load(std::memory_order_relaxed);
+            while(!buffers.compare_exchange_weak(buffer->next, buffer, std::memory_order_release, std::memory_order_relaxed));
+            localBuffer = buffer;
+        }
+        return localBuffer;
+    }
+
+    void record(const char* name, int64_t start, int64_t end) {
+        ThreadBuffer* buffer = threadBuffer();
+        Chunk* chunk = buffer->last;
+        size_t n = chunk->count.load(std::memory_order_relaxed);
+        if(n == chunkEvents) {
+            Chunk* fresh = new Chunk;
+            chunk->next.store(fresh, std::memory_order_release);
+            buffer->last = chunk = fresh;
+            n = 0;
+        }
+        Event& event = chunk->events[n];
+        event.name = name;
+        event.start = start;
+        event.duration = end - start;
+        chunk->count.store(n + 1, std::memory_order_release);
+    }
+
+    void writeName(FILE* file, const char* name) {
+        for (; *name; ++name) {
+            if((*name == '"') || (*name == '\\'))
+                fputc('\\', file);
+            fputc(*name, file);
+        }
+    }
+
+    // Dumps the trace when static objects are destroyed, i.e. on return from main or exit()
+    struct ExitDump {
+        ~ExitDump() {
+            const char* path = getenv("PB_TRACE_FILE");
+            pb::trace::dump(path ? path : "pointybox_trace.json");
+        }
+    } exitDump;
+}
+
+void pb::trace::Zone::next(const char* p_name) {
+    end();
+    name = p_name;
+    start = now();
+}
+
+void pb::trace::Zone::end() {
+    if(name)
+        record(name, start, now());
+    name = 0;
+}
+
+pb::trace::Zone::Zone(const char* p_name) :
+    name(p_name),
+    start(now())
+{ }
+
+pb::trace::Zone::~Zone() {
+    end();
+}
+
+bool pb::trace::dump(const std::string& path) {
+    FILE* file = fopen(path.c_str(), "w");
+    if(!file)
+        return false;
+    fputs("{\"traceEvents\":[", file);
+    bool first = true;
+    for (ThreadBuffer* buffer = buffers.load(std::memory_order_acquire); buffer; buffer = buffer->next) {
+        for (Chunk* chunk = buffer->first; chunk; chunk = chunk->next.load(std::memory_order_acquire)) {
+            size_t count = chunk->count.load(std::memory_order_acquire);
+            for (size_t i = 0; i < count; ++i) {
+                const Event& event = chunk->events[i];
+                fputs(first ? "\n{\"name\":\"" : ",\n{\"name\":\"", file);
+                writeName(file, event.name);
+                // Chrome wants microseconds
+                fprintf(file, "\",\"cat\":\"pointybox\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+                        event.start / 1000.0, event.duration / 1000.0, buffer->tid);
+                first = false;
+            }
+        }
+    }
+    fputs("\n],\"displayTimeUnit\":\"ms\"}\n", file);
+    return fclose(file) == 0;
+}
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef TRACE_INCLUDED
+#define TRACE_INCLUDED
+
+/*
+    Optional Chrome/Perfetto tracing of the loader and editor.
+    Build everything with -DPB_TRACE to enable it. Without it the macros below expand to nothing, so zones cost nothing and trace.cpp is empty.
+    Zones are timed with the steady clock and appended to a buffer owned by the recording thread, so recording takes no locks.
+    On exit every buffer is written as a Chrome trace JSON file to $PB_TRACE_FILE, or pointybox_trace.json if it isn't set. Open it in chrome://tracing or ui.perfetto.dev.
+    Zone names must be string literals (or otherwise outlive the program), since only the pointer is stored.
+
+        PB_TRACE_ZONE("name");                 // Lasts until the end of the enclosing scope
+        PB_TRACE_NAMED_ZONE(zone, "name");     // Same, but can be ended early or replaced:
+        PB_TRACE_NEXT(zone, "other name");     // Ends zone and starts another in its place
+        PB_TRACE_END(zone);                    // Ends zone
+*/
+
+#ifdef PB_TRACE
+
+#include <stdint.h>
+#include <string>
+
+namespace pb {
+    namespace trace {
+        class Zone {
+            const char* name;
+            int64_t start;
+
+        public:
+            void next(const char* p_name);
+            void end();
+
+            Zone(const char* p_name);
+            Zone(const Zone&) = delete;
+            Zone& operator=(const Zone&) = delete;
+            ~Zone();
+        };
+
+        bool dump(const std::string& path); // Writes everything recorded so far. Called automatically on exit
+    }
+}
+
+#define PB_TRACE_CONCAT_(a, b) a##b
+#define PB_TRACE_CONCAT(a, b) PB_TRACE_CONCAT_(a, b)
+#define PB_TRACE_ZONE(name) pb::trace::Zone PB_TRACE_CONCAT(pbTraceZone, __LINE__)(name)
+#define PB_TRACE_NAMED_ZONE(zone, name) pb::trace::Zone zone(name)
+#define PB_TRACE_NEXT(zone, name) zone.next(name)
+#define PB_TRACE_END(zone) zone.end()
+
+#else
+
+#define PB_TRACE_ZONE(name) do { } while(0)
+#define PB_TRACE_NAMED_ZONE(zone, name) do { } while(0)
+#define PB_TRACE_NEXT(zone, name) do { } while(0)
+#define PB_TRACE_END(zone) do { } while(0)
+
+#endif
+
+#endif
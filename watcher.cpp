@@ -0,0 +1,165 @@
+#include "watcher.hpp"
+#include <algorithm>
+#include <errno.h>
+#include <exception>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+static bool equal(const pb::RangeRect& a, const pb::RangeRect& b) {
+    return (a.x1 == b.x1) && (a.y1 == b.y1) && (a.x2 == b.x2) && (a.y2 == b.y2);
+}
+
+static bool equal(const pb::Vector2f& a, const pb::Vector2f& b) {
+    return (a.x == b.x) && (a.y == b.y);
+}
+
+static bool equal(const pb::AALine& a, const pb::AALine& b) {
+    return (a.x == b.x) && (a.a == b.a) && (a.s == b.s) && (a.b == b.b);
+}
+
+template < typename T >
+static bool sameSpan(const pb::Span < T >& a, const pb::Span < T >& b) {
+    if(a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if(!equal(a[i], b[i]))
+            return false;
+    }
+    return true;
+}
+
+pb::Watcher::Reader::Reader(const Watcher& p_watcher) :
+    watcher(&p_watcher),
+    generation(0)
+{ }
+
+const pb::Dataset* pb::Watcher::Reader::get() {
+    uint64_t current = watcher->gen.load(std::memory_order_acquire);
+    if((current != generation) || !data) {
+        data = std::atomic_load(&watcher->data);
+        generation = current;
+    }
+    return data.get();
+}
+
+std::shared_ptr < const pb::Dataset > pb::Watcher::reload() const {
+    PointyboxLoader ploader(file);
+    try {
+        return ploader.parse();
+    }
+    catch (const std::exception&) { // Must never escape the watcher thread. Treated like any other failed parse
+        return std::shared_ptr < const Dataset >();
+    }
+}
+
+void pb::Watcher::run() {
+    size_t slash = file.find_last_of('/');
+    std::string fileName = (slash == std::string::npos) ? file : file.substr(slash + 1);
+    alignas(inotify_event) char buf[4096];
+    pollfd fds[2] = {{inotifyFd, POLLIN, 0}, {stopPipe[0], POLLIN, 0}};
+    while(true) {
+        if(poll(fds, 2, -1) < 0) {
+            if(errno == EINTR)
+                continue;
+            break;
+        }
+        if(fds[1].revents)
+            break;
+
+        ssize_t len = read(inotifyFd, buf, sizeof(buf));
+        if(len <= 0)
+            continue;
+        bool relevant = false;
+        for (ssize_t i = 0; i < len; ) {
+            const inotify_event* event = reinterpret_cast < const inotify_event* >(buf + i);
+            if((event->len > 0) && (fileName == event->name))
+                relevant = true;
+            i += sizeof(inotify_event) + event->len;
+        }
+        if(!relevant)
+            continue;
+
+        std::shared_ptr < const Dataset > newData(reload());
+        if(!newData)
+            continue;
+        std::shared_ptr < const Dataset > oldData(std::atomic_load(&data));
+        std::atomic_store(&data, newData);
+        gen.fetch_add(1, std::memory_order_release);
+
+        if(onChange) {
+            std::vector < Slot > changed;
+            size_t ids = std::max(oldData->idCount(), newData->idCount());
+            bool sameRes = (oldData->getResolution() == newData->getResolution()); // Every value is relative to the resolution
+            for (size_t id = 0; id < ids; ++id) {
+                for (size_t bitmask = 0; bitmask < 47; ++bitmask) {
+                    // IDs missing from one version count as changed
+                    if(!sameRes || (id >= oldData->idCount()) || (id >= newData->idCount()) ||
+                       !sameSpan(oldData->getAABBs(id, bitmask), newData->getAABBs(id, bitmask)) ||
+                       !sameSpan(oldData->getPoints(id, bitmask), newData->getPoints(id, bitmask)) ||
+                       !sameSpan(oldData->getEdges(id, bitmask), newData->getEdges(id, bitmask)))
+                        changed.push_back(Slot(id, bitmask));
+                }
+            }
+            onChange(newData, changed);
+        }
+    }
+}
+
+bool pb::Watcher::start() {
+    if(thread.joinable())
+        return true;
+    std::shared_ptr < const Dataset > newData(reload());
+    if(!newData)
+        return false;
+    std::atomic_store(&data, newData);
+    gen.fetch_add(1, std::memory_order_release);
+
+    // Watch the directory instead of the file itself, so files replaced by a rename are still seen
+    size_t slash = file.find_last_of('/');
+    std::string dir = (slash == std::string::npos) ? "." : file.substr(0, slash + 1);
+    inotifyFd = inotify_init1(IN_CLOEXEC);
+    if(inotifyFd < 0)
+        return false;
+    if((inotify_add_watch(inotifyFd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) || (pipe(stopPipe) != 0)) {
+        close(inotifyFd);
+        inotifyFd = -1;
+        return false;
+    }
+    thread = std::thread(&Watcher::run, this);
+    return true;
+}
+
+void pb::Watcher::stop() {
+    if(!thread.joinable())
+        return;
+    char wake = 0;
+    ssize_t written;
+    do
+        written = write(stopPipe[1], &wake, 1);
+    while((written < 0) && (errno == EINTR));
+    close(stopPipe[1]); // Closing the write end also wakes the thread (POLLHUP), so it exits even if the write failed
+    thread.join();
+    close(inotifyFd);
+    close(stopPipe[0]);
+    inotifyFd = -1;
+}
+
+std::shared_ptr < const pb::Dataset > pb::Watcher::snapshot() const {
+    return std::atomic_load(&data);
+}
+
+uint64_t pb::Watcher::generation() const {
+    return gen.load(std::memory_order_acquire);
+}
+
+pb::Watcher::Watcher(std::string path, ChangeCallback p_onChange) :
+    file(path),
+    onChange(p_onChange),
+    gen(0),
+    inotifyFd(-1)
+{ }
+
+pb::Watcher::~Watcher() {
+    stop();
+}
@@ -0,0 +1,60 @@
+#ifndef WATCHER_INCLUDED
+#define WATCHER_INCLUDED
+
+/*
+    Hot-reloading of pointybox files.
+    A Watcher parses its file once on start, then watches it with inotify and re-parses it on a background thread whenever it is written or replaced.
+    Each successful parse is published as a new immutable Dataset through an atomic shared pointer swap; old versions stay alive while something still holds them.
+    Files which fail to parse (e.g. mid-save) are ignored and the previous version is kept.
+    Readers should use a Watcher::Reader per thread: it keeps the current version cached and only touches the shared pointer when the generation counter changes, so the common read path is a single atomic load.
+*/
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include "pointybox.hpp"
+
+namespace pb {
+    class Watcher {
+    public:
+        typedef std::pair < size_t, size_t > Slot; // (id, bitmask)
+        // Called from the watcher thread after a new version is published. changed lists every slot which differs from the previous version
+        typedef std::function < void(std::shared_ptr < const Dataset > data, const std::vector < Slot >& changed) > ChangeCallback;
+
+        class Reader {
+            const Watcher* watcher;
+            uint64_t generation;
+            std::shared_ptr < const Dataset > data;
+
+        public:
+            const Dataset* get();
+            Reader(const Watcher& p_watcher);
+        };
+
+    private:
+        std::string file;
+        ChangeCallback onChange;
+        std::shared_ptr < const Dataset > data;   // Only accessed through std::atomic_load/std::atomic_store
+        std::atomic < uint64_t > gen;
+        std::thread thread;
+        int inotifyFd,
+            stopPipe[2];
+
+        std::shared_ptr < const Dataset > reload() const;
+        void run();
+
+    public:
+        bool start();
+        void stop();
+        std::shared_ptr < const Dataset > snapshot() const;
+        uint64_t generation() const;
+
+        Watcher(std::string path, ChangeCallback p_onChange = ChangeCallback());
+        Watcher(const Watcher&) = delete;
+        Watcher& operator=(const Watcher&) = delete;
+        ~Watcher();
+    };
+}
+
+#endif